@@ -0,0 +1,206 @@
+// Measures how long the firmware takes to notice the stick falling over.
+//
+// The scripted session picks the stick up, balances it for a varying time
+// and drops it, buttons up or on its short edge, again and again. Each fall
+// is timed from the moment the noise-free pose passes 45°, where an ideal
+// classifier would report it fallen, until:
+//
+//   fallen:    `Position::GetAccelStatus()` reports `kFallen`
+//   game over: `Behavior` enters `kGameOverTransition`
+//   frame:     the first LED frame of the game over is shown
+//
+// for the median window, sample rate and burst size the firmware is built
+// with, see `tools/fall_latency_sweep.sh` to compare several. A fused pose
+// from the DMP can cross 45° a moment early, with the sensor noise, so each
+// fall is watched from its start and a latency can be negative.
+//
+// A configuration the firmware can't keep up with backs samples up in the
+// MPU FIFO until it overflows, and its latency measures the backlog rather
+// than the settings: its rows count the overflows and are marked invalid.
+//
+//   .pioenvs/native_fall_latency_benchmark/program [--falls N] [--no-header]
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "behavior.h"
+#include "configuration.h"
+#include "position.h"
+#include "scene.h"
+#include "sim.h"
+#include "stecchino.h"
+
+extern Behavior * behavior;
+extern Position * position;
+
+void setup(void);
+void loop(void);
+
+namespace {
+
+// Pick up and balance, the balance varying so falls land at every phase of
+// the sample and frame periods.
+const uint32_t kPickUpMs     = 600;
+const uint32_t kMinBalanceMs = 3000;
+const uint32_t kFallMs       = 400;
+const uint32_t kLieMs        = 2000;
+
+// A fall not detected by then counts as missed.
+const uint64_t kGiveUpMicros = 2000000;
+
+struct Fall {
+    // When the fall starts, and when the pose passes 45°.
+    uint64_t falling_us;
+    uint64_t tipped_us;
+    uint64_t fallen_us;
+    uint64_t game_over_us;
+    uint64_t frame_us;
+};
+
+Sim::Scene Session(const uint32_t falls, std::vector<Fall> * schedule) {
+    // Tilt and roll to fall to. Falling buttons down or on the long edge would
+    // put the stick to sleep or in spirit level instead of back to idle.
+    static const float kDirections[][2] = {{90.f, 0.f}, {0.f, -90.f}};
+
+    Sim::Scene scene;
+    scene.Noise(150, 20)
+        // Battery check and a short idle.
+        .Hold(8000, 90.f);
+
+    uint32_t seed = 1;
+    for (uint32_t i = 0; i < falls; ++i) {
+        seed                = seed * 1664525UL + 1013904223UL;
+        uint32_t balance_ms = kMinBalanceMs + (seed >> 16) % 1000;
+
+        scene.Move(kPickUpMs, 0.f, 0.f).Balance(balance_ms, 4.f, 0.7f);
+
+        // The fall eases in as `progress²`, so it passes 45° of 90° at `√½`.
+        uint64_t fall_us = 1000ULL * scene.GetDurationMs();
+        schedule->push_back({fall_us, fall_us + static_cast<uint64_t>(1000.0 * kFallMs * sqrt(0.5)), 0, 0, 0});
+
+        const float * direction = kDirections[i % 2];
+        scene.Move(kFallMs, direction[0], direction[1], Sim::Scene::Easing::kFall)
+            .Hold(kLieMs, direction[0], direction[1]);
+    }
+    return scene;
+}
+
+int64_t Percentile(std::vector<int64_t> values, double percentile) {
+    std::sort(values.begin(), values.end());
+    return values[static_cast<size_t>(percentile * (values.size() - 1))];
+}
+
+void Report(const char * metric, const std::vector<Fall> & falls, uint64_t Fall::*detected_us, uint32_t overflows) {
+    std::vector<int64_t> latencies;
+    for (const Fall & fall : falls) {
+        if (fall.*detected_us != 0) {
+            latencies.push_back(static_cast<int64_t>(fall.*detected_us) - static_cast<int64_t>(fall.tipped_us));
+        }
+    }
+
+    printf("%6d %6d %6d  %-10s %5zu %5zu",
+           POSITION_MEDIAN_WINDOW,
+           MPU_SAMPLE_RATE_HZ,
+           MPU_FIFO_BURST_SAMPLES,
+           metric,
+           latencies.size(),
+           falls.size() - latencies.size());
+    if (latencies.empty()) {
+        printf(" %8s %8s %8s", "-", "-", "-");
+    } else {
+        printf(" %8.1f %8.1f %8.1f",
+               Percentile(latencies, 0.50) / 1000.,
+               Percentile(latencies, 0.99) / 1000.,
+               *std::max_element(latencies.begin(), latencies.end()) / 1000.);
+    }
+    printf(" %9u%s\n", overflows, overflows > 0 ? "  invalid" : "");
+}
+
+}  // namespace
+
+int main(int argc, char ** argv) {
+    uint32_t falls  = 200;
+    bool     header = true;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--falls") == 0 && i + 1 < argc) {
+            falls = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--no-header") == 0) {
+            header = false;
+        } else {
+            fprintf(stderr, "usage: %s [--falls N] [--no-header]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<Fall> schedule;
+    Sim::Scene        scene = Session(falls, &schedule);
+
+    Sim::Reset();
+    Sim::SetDeadline(1000ULL * scene.GetDurationMs());
+    Sim::SetMotionSource(scene);
+
+    // The fall being timed, and whether its game over is still to be drawn.
+    size_t next      = 0;
+    bool   game_over = false;
+    Fall * current   = nullptr;
+    Sim::SetFrameSink([&](uint64_t micros, const uint8_t *, int, uint8_t) {
+        if (current != nullptr && game_over && current->frame_us == 0) {
+            current->frame_us = micros;
+        }
+    });
+
+    setup();
+
+    // From setup on, its own resets are not overflows.
+    uint32_t setup_overflows = Sim::GetStats().fifo_overflows;
+
+    while (!Sim::DeadlinePassed()) {
+        loop();
+
+        uint64_t now = Sim::Now();
+        if (next < schedule.size() && now >= schedule[next].falling_us) {
+            current = &schedule[next++];
+        }
+        if (current == nullptr) {
+            continue;
+        }
+
+        if (current->fallen_us == 0 && position->GetAccelStatus() == Stecchino::AccelStatus::kFallen) {
+            current->fallen_us = now;
+        }
+        if (current->game_over_us == 0 && behavior->GetState() == Stecchino::State::kGameOverTransition) {
+            current->game_over_us = now;
+            game_over             = true;
+        }
+        if (now > current->tipped_us + kGiveUpMicros) {
+            current   = nullptr;
+            game_over = false;
+        }
+    }
+
+    if (header) {
+        printf("latency from the pose passing 45° in ms, %u falls\n\n", falls);
+        printf("%6s %6s %6s  %-10s %5s %5s %8s %8s %8s %9s\n",
+               "window",
+               "rate",
+               "burst",
+               "metric",
+               "seen",
+               "miss",
+               "p50",
+               "p99",
+               "max",
+               "overflows");
+    }
+    uint32_t overflows = Sim::GetStats().fifo_overflows - setup_overflows;
+    Report("fallen", schedule, &Fall::fallen_us, overflows);
+    Report("game over", schedule, &Fall::game_over_us, overflows);
+    Report("frame", schedule, &Fall::frame_us, overflows);
+
+    return 0;
+}
@@ -0,0 +1,214 @@
+// Measures how far ahead `FallPredictor` calls a fall, and how often it calls
+// one that doesn't happen, for a sweep of confidence thresholds.
+//
+// The stick follows a scripted session of balancing, leans it recovers from,
+// 20° to 40° at various speeds, and falls, or with `--replay` a sensor trace
+// recorded with `SENSOR_TRACE` (see `tools/sensor_trace.py`). A fall is
+// `Position::GetAccelStatus()` going from `kStraight` to `kFallen`, the
+// classic 45° detection, and each threshold is checked against it:
+//
+//   call:   the confidence reaches the threshold while the stick is straight
+//   lead:   how long a call comes before the fall, if one follows within 1 s
+//   false:  a call that no fall follows within 1 s
+//
+// The firmware is built with FALL_PREDICTION for the confidence to be
+// computed, at the FALL_PREDICTION_HORIZON_MS it is built with:
+//
+//   .pioenvs/native_fall_prediction_benchmark/program [--rounds N] [--replay TRACE] [--no-header]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "configuration.h"
+#include "position.h"
+#include "scene.h"
+#include "sim.h"
+#include "stecchino.h"
+#include "traceSource.h"
+
+#if !FALL_PREDICTION
+#    error "The fall prediction benchmark needs FALL_PREDICTION"
+#endif
+
+extern Position * position;
+
+void setup(void);
+void loop(void);
+
+namespace {
+
+const uint32_t kPickUpMs     = 600;
+const uint32_t kMinBalanceMs = 2000;
+const uint32_t kFallMs       = 400;
+const uint32_t kLieMs        = 2000;
+
+// A call further ahead of the fall than this is a false one.
+const uint64_t kLeadWindowMicros = 1000000;
+
+struct Change {
+    uint64_t micros;
+    uint8_t  confidence;
+    bool     straight;
+    bool     fallen;
+};
+
+// A round is two recovered leans then a fall, in alternating directions.
+Sim::Scene Session(const uint32_t rounds) {
+    static const float kDirections[][2] = {{90.f, 0.f}, {0.f, -90.f}};
+
+    Sim::Scene scene;
+    scene.Noise(150, 20)
+        // Battery check and a short idle.
+        .Hold(8000, 90.f);
+
+    uint32_t seed = 1;
+    for (uint32_t i = 0; i < rounds; ++i) {
+        const float * direction = kDirections[i % 2];
+
+        scene.Move(kPickUpMs, 0.f, 0.f);
+        for (int lean = 0; lean < 2; ++lean) {
+            seed                = seed * 1664525UL + 1013904223UL;
+            uint32_t balance_ms = kMinBalanceMs + (seed >> 16) % 1000;
+            float    lean_deg   = 20.f + static_cast<float>((seed >> 8) % 21);
+            uint32_t lean_ms    = 150 + (seed >> 20) % 450;
+
+            scene.Balance(balance_ms, 4.f, 0.7f)
+                .Move(lean_ms, lean_deg * direction[0] / 90.f, lean_deg * direction[1] / 90.f)
+                .Move(lean_ms * 2, 0.f, 0.f);
+        }
+
+        scene.Balance(kMinBalanceMs, 4.f, 0.7f)
+            .Move(kFallMs, direction[0], direction[1], Sim::Scene::Easing::kFall)
+            .Hold(kLieMs, direction[0], direction[1]);
+    }
+    return scene;
+}
+
+int64_t Percentile(std::vector<int64_t> values, double percentile) {
+    std::sort(values.begin(), values.end());
+    return values[static_cast<size_t>(percentile * (values.size() - 1))];
+}
+
+void Report(const uint8_t threshold, const std::vector<Change> & changes, const std::vector<uint64_t> & falls,
+            const double minutes) {
+    // Each fall's earliest call, 0 for none.
+    std::vector<uint64_t> called(falls.size(), 0);
+    uint32_t              false_calls = 0;
+
+    bool above = false;
+    for (const Change & change : changes) {
+        bool was_above = above;
+        above          = change.confidence >= threshold;
+        if (!above || was_above || !change.straight) {
+            continue;
+        }
+
+        auto next = std::lower_bound(falls.begin(), falls.end(), change.micros);
+        if (next == falls.end() || *next - change.micros > kLeadWindowMicros) {
+            ++false_calls;
+            continue;
+        }
+        uint64_t & call = called[next - falls.begin()];
+        if (call == 0) {
+            call = change.micros;
+        }
+    }
+
+    std::vector<int64_t> leads;
+    for (size_t i = 0; i < falls.size(); ++i) {
+        if (called[i] != 0) {
+            leads.push_back(static_cast<int64_t>(falls[i] - called[i]));
+        }
+    }
+
+    printf("%9u %6zu %6zu", threshold, leads.size(), falls.size() - leads.size());
+    if (leads.empty()) {
+        printf(" %8s %8s", "-", "-");
+    } else {
+        printf(" %8.1f %8.1f", Percentile(leads, 0.50) / 1000., *std::min_element(leads.begin(), leads.end()) / 1000.);
+    }
+    printf(" %6u %8.2f\n", false_calls, minutes > 0 ? false_calls / minutes : 0.);
+}
+
+}  // namespace
+
+int main(int argc, char ** argv) {
+    uint32_t     rounds = 100;
+    const char * replay = nullptr;
+    bool         header = true;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+            rounds = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replay = argv[++i];
+        } else if (strcmp(argv[i], "--no-header") == 0) {
+            header = false;
+        } else {
+            fprintf(stderr, "usage: %s [--rounds N] [--replay TRACE] [--no-header]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    Sim::Reset();
+    if (replay != nullptr) {
+        Sim::TraceSource trace;
+        if (!trace.Load(replay)) {
+            fprintf(stderr, "%s: no sensor trace records\n", replay);
+            return 1;
+        }
+        Sim::SetDeadline(trace.GetEndMicros());
+        Sim::SetMotionSource(trace);
+    } else {
+        Sim::Scene scene = Session(rounds);
+        Sim::SetDeadline(1000ULL * scene.GetDurationMs());
+        Sim::SetMotionSource(scene);
+    }
+
+    std::vector<Change>   changes;
+    std::vector<uint64_t> falls;
+    Change                last = {0, 0, false, false};
+    // Whether the stick was last straight rather than fallen, across any
+    // unknown status between the two.
+    bool was_straight = false;
+
+    setup();
+
+    while (!Sim::DeadlinePassed()) {
+        loop();
+
+        Stecchino::AccelStatus status = position->GetAccelStatus();
+        Change                 change = {Sim::Now(),
+                         position->GetFallConfidence(),
+                         status == Stecchino::AccelStatus::kStraight,
+                         status == Stecchino::AccelStatus::kFallen};
+        if (change.fallen && was_straight) {
+            falls.push_back(change.micros);
+        }
+        if (change.fallen || change.straight) {
+            was_straight = change.straight;
+        }
+        if (change.confidence != last.confidence || change.straight != last.straight) {
+            changes.push_back(change);
+            last = change;
+        }
+    }
+
+    double minutes = Sim::Now() / 60e6;
+    if (header) {
+        printf("calls ahead of the 45° detection in ms, %zu falls in %.1f minutes, %d ms horizon\n\n",
+               falls.size(),
+               minutes,
+               FALL_PREDICTION_HORIZON_MS);
+        printf("%9s %6s %6s %8s %8s %6s %8s\n", "threshold", "called", "missed", "p50", "min", "false", "per min");
+    }
+    for (uint16_t threshold = 32; threshold < 255; threshold += 32) {
+        Report(static_cast<uint8_t>(threshold), changes, falls, minutes);
+    }
+    Report(255, changes, falls, minutes);
+
+    return 0;
+}
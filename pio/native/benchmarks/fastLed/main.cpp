@@ -0,0 +1,242 @@
+// Times the FastLED kernels the LED patterns are built from, to see which
+// animations fit in a frame alongside the sensor pipeline.
+//
+// Strip kernels cover all NUM_LEDS pixels per call, the others are a single
+// call. The host build reports ns per call, best of 5, to compare kernels and
+// catch regressions:
+//
+//   platformio run -e native_fastled_benchmark && .pioenvs/native_fastled_benchmark/program
+//
+// Only the AVR build says what fits in a frame: the AVR lib8tion swaps in its
+// assembly kernels, and a host core is no guide to an 8-bit one. It counts
+// each call's cycles with Timer1 and writes them to Serial at 115200, on the
+// board or under simavr, which exits once the report is written:
+//
+//   platformio run -e protrinket3ftdi_fastled_benchmark
+//   simavr -m atmega328p -f 12000000 .pioenvs/protrinket3ftdi_fastled_benchmark/firmware.elf
+//
+// No AVR counts have been taken yet, so none are quoted here. The first run's
+// report belongs here, with the FastLED version it was built against. A
+// call longer than Timer1's 65535 cycles is reported as such, not counted.
+
+#include <FastLED.h>
+
+#include "configuration.h"
+
+#ifdef __AVR__
+#    include <avr/interrupt.h>
+#    include <avr/io.h>
+#    include <avr/sleep.h>
+#else
+#    include <stdio.h>
+
+#    include <algorithm>
+#    include <chrono>
+#endif
+
+namespace {
+
+CRGB leds[NUM_LEDS];
+
+// Keeps the results from being optimized away.
+volatile uint16_t sink;
+
+void HsvToRgbRainbow(uint16_t iteration) {
+    for (uint8_t i = 0; i < NUM_LEDS; ++i) {
+        hsv2rgb_rainbow(CHSV(iteration + 3 * i, 255, 255), leds[i]);
+    }
+}
+
+void FadeToBlackBy(uint16_t iteration) { fadeToBlackBy(leds, NUM_LEDS, 10 + (iteration & 15)); }
+
+void Nscale8(uint16_t iteration) { nscale8(leds, NUM_LEDS, 192 + (iteration & 63)); }
+
+void ColorFromPaletteStrip(uint16_t iteration) {
+    for (uint8_t i = 0; i < NUM_LEDS; ++i) {
+        leds[i] = ColorFromPalette(RainbowColors_p, iteration + 3 * i, 255, LINEARBLEND);
+    }
+}
+
+void Beatsin16(uint16_t iteration) {
+    (void)iteration;
+    sink = beatsin16(13, 0, NUM_LEDS - 1);
+}
+
+void Random16(uint16_t iteration) {
+    (void)iteration;
+    sink = random16(NUM_LEDS);
+}
+
+void Inoise8(uint16_t iteration) { sink = inoise8(iteration * 37, iteration * 11); }
+
+struct Kernel {
+    const char * name;
+    // Whether each call covers the whole strip.
+    bool strip;
+    void (*run)(uint16_t iteration);
+};
+
+// `fadeToBlackBy()` and `nscale8()` take the same time whatever the pixels,
+// so they don't need the strip refilled as it fades.
+const Kernel kKernels[] = {
+    {"hsv2rgb_rainbow", true, HsvToRgbRainbow},
+    {"fadeToBlackBy", true, FadeToBlackBy},
+    {"nscale8", true, Nscale8},
+    {"ColorFromPalette", true, ColorFromPaletteStrip},
+    {"beatsin16", false, Beatsin16},
+    {"random16", false, Random16},
+    {"inoise8", false, Inoise8},
+};
+
+const uint8_t kKernelCount = sizeof(kKernels) / sizeof(kKernels[0]);
+
+}  // namespace
+
+#ifdef __AVR__
+
+namespace {
+
+// Input varies with the iteration, so the mean and max cover the kernels'
+// data-dependent branches.
+const uint16_t kIterations = 256;
+
+// A frame's share of the CPU at FRAMES_PER_SECOND.
+const uint32_t kFrameCycles = F_CPU / FRAMES_PER_SECOND;
+
+void Empty(uint16_t iteration) { (void)iteration; }
+
+// Cycles of one call, with interrupts off, or 0xFFFF if Timer1 wrapped.
+uint16_t CountCycles(void (*run)(uint16_t iteration), const uint16_t iteration) {
+    uint8_t sreg = SREG;
+    cli();
+    TCNT1 = 0;
+    TIFR1 = _BV(TOV1);
+    run(iteration);
+    uint16_t cycles  = TCNT1;
+    bool     wrapped = TIFR1 & _BV(TOV1);
+    SREG             = sreg;
+    return wrapped ? 0xFFFF : cycles;
+}
+
+void PrintColumn(const uint32_t value, const uint8_t width) {
+    uint32_t limit = 10;
+    for (uint8_t digits = 1; digits < width; ++digits, limit *= 10) {
+        if (value < limit) {
+            Serial.print(' ');
+        }
+    }
+    Serial.print(value);
+}
+
+}  // namespace
+
+void setup() {
+    Serial.begin(115200);
+
+    // Timer1 counts CPU cycles.
+    TCCR1A = 0;
+    TCCR1B = _BV(CS10);
+
+    for (uint8_t i = 0; i < NUM_LEDS; ++i) {
+        leds[i] = CHSV(3 * i, 255, 255);
+    }
+
+    // What the timing itself costs, taken off every count.
+    uint16_t overhead = 0xFFFF;
+    for (uint16_t iteration = 0; iteration < 16; ++iteration) {
+        uint16_t cycles = CountCycles(Empty, iteration);
+        overhead        = min(overhead, cycles);
+    }
+
+    Serial.print(F("cycles per call, "));
+    Serial.print(kIterations);
+    Serial.print(F(" calls, "));
+    Serial.print(kFrameCycles);
+    Serial.println(F(" cycles per frame"));
+    Serial.println();
+    Serial.println(F("kernel              per     mean      max  per LED  frame %"));
+
+    for (uint8_t k = 0; k < kKernelCount; ++k) {
+        const Kernel & kernel = kKernels[k];
+
+        uint32_t total   = 0;
+        uint16_t longest = 0;
+        bool     wrapped = false;
+        for (uint16_t iteration = 0; iteration < kIterations && !wrapped; ++iteration) {
+            uint16_t cycles = CountCycles(kernel.run, iteration);
+            wrapped         = cycles == 0xFFFF;
+            cycles -= overhead;
+            total += cycles;
+            longest = max(longest, cycles);
+        }
+
+        Serial.print(kernel.name);
+        for (uint8_t pad = strlen(kernel.name); pad < 18; ++pad) {
+            Serial.print(' ');
+        }
+        Serial.print(kernel.strip ? F("strip") : F(" call"));
+        if (wrapped) {
+            Serial.println(F("  over 65535 cycles"));
+            continue;
+        }
+        PrintColumn(total / kIterations, 9);
+        PrintColumn(longest, 9);
+        PrintColumn(kernel.strip ? longest / NUM_LEDS : longest, 9);
+        // In tenths of a percent.
+        uint32_t permille = 1000UL * longest / kFrameCycles;
+        PrintColumn(permille / 10, 7);
+        Serial.print('.');
+        Serial.println(static_cast<int>(permille % 10));
+    }
+
+    // Sleeping with interrupts off ends a simavr run, and idles a board.
+    Serial.flush();
+    cli();
+    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+    sleep_enable();
+    sleep_cpu();
+}
+
+void loop() {}
+
+#else
+
+namespace {
+
+const uint32_t kIterations = 20000;
+
+double TimeKernel(const Kernel & kernel) {
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t iteration = 0; iteration < kIterations; ++iteration) {
+        kernel.run(static_cast<uint16_t>(iteration));
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / kIterations;
+}
+
+}  // namespace
+
+int main(void) {
+    for (uint8_t i = 0; i < NUM_LEDS; ++i) {
+        leds[i] = CHSV(3 * i, 255, 255);
+    }
+
+    printf("ns per call, %u calls, best of 5, strips of %d LEDs\n\n", kIterations, NUM_LEDS);
+    printf("%-18s %5s %10s %10s\n", "kernel", "per", "ns", "per LED");
+
+    for (const Kernel & kernel : kKernels) {
+        double ns = 1e9;
+        for (int run = 0; run < 5; ++run) {
+            ns = std::min(ns, TimeKernel(kernel));
+        }
+        printf("%-18s %5s %10.1f", kernel.name, kernel.strip ? "strip" : "call", ns);
+        if (kernel.strip) {
+            printf(" %10.2f\n", ns / NUM_LEDS);
+        } else {
+            printf(" %10s\n", "-");
+        }
+    }
+
+    return 0;
+}
+
+#endif
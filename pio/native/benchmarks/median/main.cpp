@@ -0,0 +1,156 @@
+// Compares `MedianFilter` with the `RunningMedian` library it replaced in
+// `Position`, for every window size `RunningMedian` supports from 5 up.
+//
+// Each sample adds the three accel axes and takes their medians, as
+// `Position` did with one `RunningMedian` per axis. Two traces are used: the
+// scripted play session at `MPU_SAMPLE_RATE_HZ`, and uniform noise, the worst
+// case for `MedianFilter` as each new sample lands anywhere in the window.
+// Every median is checked against `RunningMedian`.
+//
+//   platformio run -e native_median_benchmark && .pioenvs/native_median_benchmark/program
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include <RunningMedian.h>
+
+#include "configuration.h"
+#include "medianFilter.h"
+#include "scene.h"
+
+namespace {
+
+const int kAxes = 3;
+
+typedef std::vector<Sim::Accel> Trace;
+
+Trace SessionTrace(void) {
+    Sim::Scene scene = Sim::Scene::Session();
+    Trace      trace;
+    for (uint64_t micros = 0; micros < 1000ULL * scene.GetDurationMs(); micros += 1000000 / MPU_SAMPLE_RATE_HZ) {
+        trace.push_back(scene(micros).accel);
+    }
+    return trace;
+}
+
+Trace NoiseTrace(size_t length) {
+    Trace    trace(length);
+    uint32_t seed = 1;
+    auto     next = [&seed](void) {
+        seed = seed * 1664525UL + 1013904223UL;
+        return static_cast<int16_t>(seed >> 16);
+    };
+    for (auto & accel : trace) {
+        accel.x = next();
+        accel.y = next();
+        accel.z = next();
+    }
+    return trace;
+}
+
+// Keeps the medians from being optimized away.
+volatile float sink;
+
+template <uint8_t kWindow>
+double TimeRunningMedian(const Trace & trace, std::vector<float> * medians) {
+    RunningMedian forward(kWindow);
+    RunningMedian sideway(kWindow);
+    RunningMedian vertical(kWindow);
+
+    auto start = std::chrono::steady_clock::now();
+    for (const auto & accel : trace) {
+        forward.add(accel.x);
+        sideway.add(accel.y);
+        vertical.add(accel.z);
+        float median_forward  = forward.getMedian();
+        float median_sideway  = sideway.getMedian();
+        float median_vertical = vertical.getMedian();
+        if (medians != nullptr) {
+            medians->push_back(median_forward);
+            medians->push_back(median_sideway);
+            medians->push_back(median_vertical);
+        }
+        sink = median_forward + median_sideway + median_vertical;
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / trace.size();
+}
+
+template <uint8_t kWindow>
+double TimeMedianFilter(const Trace & trace, std::vector<float> * medians) {
+    MedianFilter<int16_t, kAxes, kWindow> filter;
+
+    auto start = std::chrono::steady_clock::now();
+    for (const auto & accel : trace) {
+        const int16_t axes[kAxes] = {accel.x, accel.y, accel.z};
+        filter.Add(axes);
+        float median_forward  = filter.GetMedian(0);
+        float median_sideway  = filter.GetMedian(1);
+        float median_vertical = filter.GetMedian(2);
+        if (medians != nullptr) {
+            medians->push_back(median_forward);
+            medians->push_back(median_sideway);
+            medians->push_back(median_vertical);
+        }
+        sink = median_forward + median_sideway + median_vertical;
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / trace.size();
+}
+
+// Best of a few runs, after checking the medians match.
+template <uint8_t kWindow>
+void Compare(const char * name, const Trace & trace) {
+    std::vector<float> expected;
+    std::vector<float> actual;
+    TimeRunningMedian<kWindow>(trace, &expected);
+    TimeMedianFilter<kWindow>(trace, &actual);
+    if (expected != actual) {
+        fprintf(stderr, "%s, window %d: medians differ from RunningMedian\n", name, kWindow);
+        exit(1);
+    }
+
+    double running_median_ns = 1e9;
+    double median_filter_ns  = 1e9;
+    for (int run = 0; run < 5; ++run) {
+        running_median_ns = std::min(running_median_ns, TimeRunningMedian<kWindow>(trace, nullptr));
+        median_filter_ns  = std::min(median_filter_ns, TimeMedianFilter<kWindow>(trace, nullptr));
+    }
+
+    printf("%-8s %6d %16.1f %15.1f %8.1fx\n",
+           name,
+           kWindow,
+           running_median_ns,
+           median_filter_ns,
+           running_median_ns / median_filter_ns);
+}
+
+template <uint8_t kWindow, uint8_t kLastWindow>
+struct CompareWindows {
+    static void Run(const char * name, const Trace & trace) {
+        Compare<kWindow>(name, trace);
+        CompareWindows<kWindow + 1, kLastWindow>::Run(name, trace);
+    }
+};
+
+template <uint8_t kLastWindow>
+struct CompareWindows<kLastWindow, kLastWindow> {
+    static void Run(const char * name, const Trace & trace) { Compare<kLastWindow>(name, trace); }
+};
+
+}  // namespace
+
+int main(void) {
+    Trace session = SessionTrace();
+    Trace noise   = NoiseTrace(session.size());
+
+    printf("%zu samples of 3 axes per trace, ns per sample (add and 3 medians), best of 5\n\n", session.size());
+    printf("%-8s %6s %16s %15s %9s\n", "trace", "window", "RunningMedian", "MedianFilter", "speedup");
+
+    CompareWindows<5, MEDIAN_MAX_SIZE>::Run("session", session);
+    CompareWindows<5, MEDIAN_MAX_SIZE>::Run("noise", noise);
+
+    return 0;
+}
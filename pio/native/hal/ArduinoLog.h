@@ -0,0 +1,88 @@
+#pragma once
+
+// Host build of the ArduinoLog API: same levels, format specifiers and output,
+// written to any `Print` (normally the simulated Serial port, so log traffic
+// costs the same simulated time as on the device).
+
+#include <stdarg.h>
+
+#include <Arduino.h>
+
+#define LOG_LEVEL_SILENT 0
+#define LOG_LEVEL_FATAL 1
+#define LOG_LEVEL_ERROR 2
+#define LOG_LEVEL_WARNING 3
+#define LOG_LEVEL_NOTICE 4
+#define LOG_LEVEL_TRACE 5
+#define LOG_LEVEL_VERBOSE 6
+
+#define CR "\n"
+
+typedef void (*printfunction)(Print *);
+
+class Logging {
+  public:
+    Logging(void) : level_(LOG_LEVEL_SILENT), show_level_(true), output_(nullptr), prefix_(nullptr), suffix_(nullptr) {}
+
+    void begin(int level, Print * output, bool show_level = true);
+
+    void setPrefix(printfunction f) { prefix_ = f; }
+    void setSuffix(printfunction f) { suffix_ = f; }
+
+    template <class T, typename... Args>
+    void fatal(T msg, Args... args) {
+#ifndef DISABLE_LOGGING
+        PrintLevel(LOG_LEVEL_FATAL, msg, args...);
+#endif
+    }
+
+    template <class T, typename... Args>
+    void error(T msg, Args... args) {
+#ifndef DISABLE_LOGGING
+        PrintLevel(LOG_LEVEL_ERROR, msg, args...);
+#endif
+    }
+
+    template <class T, typename... Args>
+    void warning(T msg, Args... args) {
+#ifndef DISABLE_LOGGING
+        PrintLevel(LOG_LEVEL_WARNING, msg, args...);
+#endif
+    }
+
+    template <class T, typename... Args>
+    void notice(T msg, Args... args) {
+#ifndef DISABLE_LOGGING
+        PrintLevel(LOG_LEVEL_NOTICE, msg, args...);
+#endif
+    }
+
+    template <class T, typename... Args>
+    void trace(T msg, Args... args) {
+#ifndef DISABLE_LOGGING
+        PrintLevel(LOG_LEVEL_TRACE, msg, args...);
+#endif
+    }
+
+    template <class T, typename... Args>
+    void verbose(T msg, Args... args) {
+#ifndef DISABLE_LOGGING
+        PrintLevel(LOG_LEVEL_VERBOSE, msg, args...);
+#endif
+    }
+
+  private:
+    int           level_;
+    bool          show_level_;
+    Print *       output_;
+    printfunction prefix_;
+    printfunction suffix_;
+
+    void PrintLevel(int level, const char * msg, ...);
+    void PrintLevel(int level, const __FlashStringHelper * msg, ...);
+
+    void VPrintLevel(int level, const char * msg, va_list * args);
+    void PrintFormat(char format, va_list * args);
+};
+
+extern Logging Log;
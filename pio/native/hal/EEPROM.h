@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stdint.h>
+
+// EEPROM model: the 1 KB of the ATmega328P, erased to 0xFF by `Sim::Reset()`.
+// As with `eeprom_write_byte()`, a write returns at once but the next one
+// spins until the previous has taken its 3.4 ms.
+class EEPROMClass {
+  public:
+    uint8_t read(int index);
+    void    write(int index, uint8_t value);
+    void    update(int index, uint8_t value);
+
+    uint16_t length(void) const;
+};
+
+extern EEPROMClass EEPROM;
@@ -0,0 +1,140 @@
+// Host build of FastLED.
+//
+// The portable parts of the vendored FastLED (pixel types, lib8tion, hsv2rgb,
+// colorutils, palettes, noise, power management, CLEDController) are used as
+// is; only the platform layer is replaced. `CFastLED` keeps the real `show()`
+// semantics (refresh-rate cap, power limiting, brightness scaling) but hands
+// each frame to the simulation instead of bit-banging a pin, and charges the
+// simulated clock for the WS2812 transfer with interrupts disabled.
+//
+// Defining the vendored include guard makes its own `#include "FastLED.h"`
+// lines resolve to this file.
+
+#ifndef __INC_FASTSPI_LED2_H
+#define __INC_FASTSPI_LED2_H
+
+#define FASTLED_VERSION 3001005
+
+#include <stdint.h>
+
+#include <vector>
+
+#include <Arduino.h>
+
+// Stand-in for led_sysdefs.h, which would select the AVR platform.
+#define __INC_LED_SYSDEFS_H
+#define FASTLED_NAMESPACE_BEGIN
+#define FASTLED_NAMESPACE_END
+#define FASTLED_USING_NAMESPACE
+#define FASTLED_USE_PROGMEM 0
+#define CLKS_PER_US (F_CPU / 1000000)
+
+#include "cpp_compat.h"
+#include "fastled_config.h"
+#include "fastled_progmem.h"
+
+#include "lib8tion.h"
+#include "pixeltypes.h"
+#include "hsv2rgb.h"
+#include "colorutils.h"
+#include "pixelset.h"
+#include "colorpalettes.h"
+
+#include "noise.h"
+#include "power_mgt.h"
+
+#include "controller.h"
+
+// WS2812 timing: 24 bits at 800kHz per LED, then a 50µs latch.
+#define WS2812_US_PER_LED 30
+#define WS2812_LATCH_US 50
+
+// Captures frames for the simulation; one per `addLeds` call.
+//
+// Models the strip itself: showing fewer LEDs than it has updates only that
+// prefix, the pixels past it keep their colors, and the frame sink sees the
+// whole strip.
+class SimController : public CLEDController {
+  public:
+    SimController(uint16_t max_refresh_rate) : max_refresh_rate_(max_refresh_rate) {}
+
+    virtual void     init() {}
+    virtual uint16_t getMaxRefreshRate() const { return max_refresh_rate_; }
+
+  protected:
+    virtual void showColor(const struct CRGB & data, int nLeds, CRGB scale);
+    virtual void show(const struct CRGB * data, int nLeds, CRGB scale);
+
+  private:
+    uint16_t max_refresh_rate_;
+
+    // Colors latched by the strip's pixels, as packed RGB triplets.
+    std::vector<uint8_t> strip_;
+};
+
+template <uint8_t DATA_PIN, EOrder RGB_ORDER>
+class WS2812B {
+  public:
+    static const uint16_t kMaxRefreshRate = 400;
+};
+
+template <uint8_t DATA_PIN, EOrder RGB_ORDER>
+class WS2812 : public WS2812B<DATA_PIN, RGB_ORDER> {};
+
+template <uint8_t DATA_PIN, EOrder RGB_ORDER>
+class NEOPIXEL : public WS2812B<DATA_PIN, RGB_ORDER> {};
+
+typedef uint8_t (*power_func)(uint8_t scale, uint32_t data);
+
+class CFastLED {
+  public:
+    CFastLED(void);
+
+    template <template <uint8_t DATA_PIN, EOrder RGB_ORDER> class CHIPSET, uint8_t DATA_PIN, EOrder RGB_ORDER>
+    static CLEDController & addLeds(struct CRGB * data, int nLedsOrOffset, int nLedsIfOffset = 0) {
+        static SimController c(CHIPSET<DATA_PIN, RGB_ORDER>::kMaxRefreshRate);
+        return addLeds(&c, data, nLedsOrOffset, nLedsIfOffset);
+    }
+
+    static CLEDController & addLeds(CLEDController * pLed,
+                                    struct CRGB *    data,
+                                    int              nLedsOrOffset,
+                                    int              nLedsIfOffset = 0);
+
+    void    setBrightness(uint8_t scale) { m_Scale = scale; }
+    uint8_t getBrightness() { return m_Scale; }
+
+    inline void setMaxPowerInVoltsAndMilliamps(uint8_t volts, uint32_t milliamps) {
+        setMaxPowerInMilliWatts(volts * milliamps);
+    }
+    inline void setMaxPowerInMilliWatts(uint32_t milliwatts) {
+        m_pPowerFunc  = &calculate_max_brightness_for_power_mW;
+        m_nPowerData  = milliwatts;
+    }
+
+    void show(uint8_t scale);
+    void show() { show(m_Scale); }
+
+    void clear(bool writeData = false);
+    void clearData();
+
+    void delay(unsigned long ms);
+
+    void setMaxRefreshRate(uint16_t refresh, bool constrain = false);
+
+    int                   count();
+    CLEDController &      operator[](int x);
+    int                   size() { return (*this)[0].size(); }
+    CRGB *                leds() { return (*this)[0].leds(); }
+
+  private:
+    uint8_t    m_Scale;
+    uint32_t   m_nMinMicros;
+    uint32_t   m_nPowerData;
+    power_func m_pPowerFunc;
+    uint32_t   lastshow;
+};
+
+extern CFastLED FastLED;
+
+#endif
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "Print.h"
+
+// UART model: every byte costs 10 bit times at the configured baud rate and
+// writes block once the 64-byte transmit buffer of the AVR core is full.
+class HardwareSerial : public Print {
+  public:
+    void begin(unsigned long baud);
+    void end(void);
+
+    // The bytes set with `Sim::SetSerialInput()`.
+    int available(void);
+    int read(void);
+    int peek(void);
+
+    size_t write(uint8_t c) override;
+    using Print::write;
+
+    void flush(void) override;
+
+    operator bool(void) const { return true; }
+
+  private:
+    static const uint8_t kTxBufferSize = 64;
+
+    unsigned long baud_ = 9600;
+
+    // Simulated time at which the last queued byte leaves the wire.
+    uint64_t tx_busy_until_ = 0;
+};
+
+extern HardwareSerial Serial;
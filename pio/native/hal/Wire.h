@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BUFFER_LENGTH 32
+
+namespace Sim {
+
+// A device on the simulated I2C bus. `Receive` gets the bytes of a write
+// transaction, `Transmit` fills the bytes of a read transaction.
+class I2cDevice {
+  public:
+    virtual ~I2cDevice(void) {}
+
+    virtual void    Receive(const uint8_t * data, uint8_t count) = 0;
+    virtual uint8_t Transmit(uint8_t * data, uint8_t count)      = 0;
+};
+
+void AttachI2cDevice(uint8_t address, I2cDevice * device);
+
+}  // namespace Sim
+
+// Wire model: transfers complete immediately but advance the simulated clock
+// by the time the bytes take on the bus at the configured SCL frequency.
+class TwoWire {
+  public:
+    void begin(void);
+    void end(void) {}
+    void setClock(uint32_t frequency);
+
+    void    beginTransmission(uint8_t address);
+    void    beginTransmission(int address) { beginTransmission(static_cast<uint8_t>(address)); }
+    uint8_t endTransmission(bool send_stop = true);
+
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, bool send_stop = true);
+    uint8_t requestFrom(int address, int quantity, int send_stop = 1) {
+        return requestFrom(static_cast<uint8_t>(address), static_cast<uint8_t>(quantity), send_stop != 0);
+    }
+
+    size_t write(uint8_t data);
+    size_t write(const uint8_t * data, size_t quantity);
+
+    int available(void) { return rx_length_ - rx_index_; }
+    int read(void) { return rx_index_ < rx_length_ ? rx_buffer_[rx_index_++] : -1; }
+    int peek(void) { return rx_index_ < rx_length_ ? rx_buffer_[rx_index_] : -1; }
+
+  private:
+    uint32_t frequency_ = 100000;
+
+    uint8_t tx_address_ = 0;
+    uint8_t tx_buffer_[BUFFER_LENGTH];
+    uint8_t tx_length_ = 0;
+
+    uint8_t rx_buffer_[BUFFER_LENGTH];
+    uint8_t rx_length_ = 0;
+    uint8_t rx_index_  = 0;
+
+    void ChargeBus(uint8_t bytes);
+};
+
+extern TwoWire Wire;
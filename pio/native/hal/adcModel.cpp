@@ -0,0 +1,128 @@
+#include <Arduino.h>
+
+#include "sim.h"
+#include "simModels.h"
+
+// ADC model: a conversion started with ADSC completes 13 ADC clocks later
+// (25 for the first one after enabling) and converts the selected channel.
+// Only the internal 1.1V bandgap measured against AVcc is modelled, which is
+// what `BatteryLevel` uses to infer Vcc.
+
+namespace {
+
+const uint8_t  kMuxMask          = 0x0F;
+const uint8_t  kMuxBandgap       = 0x0E;
+const uint32_t kBandgapMillivolt = 1100;
+
+uint64_t conversion_done_us = 0;
+bool     converting         = false;
+bool     first_conversion   = true;
+
+uint32_t AdcClockUs(void) {
+    // Prescaler from ADPS2:0, off the system clock.
+    static const uint8_t kDivisionFactor[] = {2, 2, 4, 8, 16, 32, 64, 128};
+    uint32_t period_us = (kDivisionFactor[ADCSRA.Get() & 0x07] * 1000000UL + F_CPU / 2) / F_CPU;
+    return period_us > 0 ? period_us : 1;
+}
+
+uint16_t Convert(void) {
+    if ((ADMUX.Get() & kMuxMask) != kMuxBandgap) {
+        return 0;
+    }
+
+    int vcc = Sim::GetVccMillivolts();
+    if (vcc <= 0) {
+        return 1023;
+    }
+
+    uint32_t result = (kBandgapMillivolt * 1023UL + vcc / 2) / static_cast<uint32_t>(vcc);
+    return static_cast<uint16_t>(min(result, 1023UL));
+}
+
+void Complete(void) {
+    converting       = false;
+    first_conversion = false;
+
+    uint16_t result = Convert();
+    if (ADMUX.Get() & _BV(ADLAR)) {
+        result <<= 6;
+    }
+    ADCL.Set(static_cast<uint8_t>(result & 0xFF));
+    ADCH.Set(static_cast<uint8_t>(result >> 8));
+
+    ++Sim::MutableStats().adc_conversions;
+
+    uint8_t status = ADCSRA.Get();
+    status         = static_cast<uint8_t>((status & ~_BV(ADSC)) | _BV(ADIF));
+    ADCSRA.Set(status);
+
+    if ((status & _BV(ADIE)) && (SREG.Get() & _BV(SREG_I)) && ADC_vect != nullptr) {
+        // The hardware clears ADIF when it vectors to the ISR.
+        ADCSRA.Set(static_cast<uint8_t>(status & ~_BV(ADIF)));
+        ADC_vect();
+    }
+}
+
+void OnAdcsraWrite(Sim::Register & reg, uint8_t previous) {
+    uint8_t value = reg.Get();
+
+    // ADIF is cleared by writing a one to it.
+    if (value & _BV(ADIF)) {
+        value = static_cast<uint8_t>(value & ~_BV(ADIF));
+    } else if (previous & _BV(ADIF)) {
+        value = static_cast<uint8_t>(value | _BV(ADIF));
+    }
+
+    if (!(value & _BV(ADEN))) {
+        first_conversion = true;
+        converting       = false;
+        value            = static_cast<uint8_t>(value & ~_BV(ADSC));
+    } else if ((value & _BV(ADSC)) && !converting) {
+        converting         = true;
+        conversion_done_us = Sim::Now() + (first_conversion ? 25 : 13) * AdcClockUs();
+    }
+
+    reg.Set(value);
+}
+
+void OnAdcsraRead(Sim::Register &) {
+    if (!converting) {
+        return;
+    }
+
+    // Polling a conversion in flight: spin for one ADC clock.
+    if (Sim::Now() < conversion_done_us) {
+        Sim::Advance(AdcClockUs());
+    }
+    Sim::TickAdc();
+}
+
+}  // namespace
+
+Sim::Register ADMUX;
+Sim::Register ADCSRA(OnAdcsraWrite, OnAdcsraRead);
+Sim::Register ADCSRB;
+Sim::Register ADCL;
+Sim::Register ADCH;
+
+namespace Sim {
+
+void ResetAdc(void) {
+    // As left by the Arduino core `init()`: enabled, clock divided by 128.
+    ADMUX.Set(0);
+    ADCSRA.Set(_BV(ADEN) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0));
+    ADCSRB.Set(0);
+    ADCL.Set(0);
+    ADCH.Set(0);
+
+    converting       = false;
+    first_conversion = true;
+}
+
+void TickAdc(void) {
+    if (converting && Now() >= conversion_done_us) {
+        Complete();
+    }
+}
+
+}  // namespace Sim
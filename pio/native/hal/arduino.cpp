@@ -0,0 +1,105 @@
+#include <Arduino.h>
+
+#include "sim.h"
+#include "simModels.h"
+
+// Status, sleep and power reduction registers have no side effects of their
+// own; the sleep and interrupt models read them.
+Sim::Register SREG;
+Sim::Register SMCR;
+Sim::Register PRR;
+
+namespace {
+
+const uint8_t kNumPins = 20;
+
+// Reading the timer0 overflow count with interrupts off takes a few dozen
+// cycles, so a loop that only polls the clock still moves it forward.
+const uint32_t kMillisCostUs = 3;
+const uint32_t kMicrosCostUs = 5;
+
+uint8_t pin_modes[kNumPins];
+uint8_t pin_levels[kNumPins];
+
+}  // namespace
+
+unsigned long millis(void) {
+    Sim::Advance(kMillisCostUs);
+    return static_cast<unsigned long>(Sim::Now() / 1000);
+}
+
+unsigned long micros(void) {
+    Sim::Advance(kMicrosCostUs);
+    return static_cast<unsigned long>(Sim::Now());
+}
+
+void delay(unsigned long ms) {
+    Sim::MutableStats().delay_us += 1000ULL * ms;
+    while (ms > 0) {
+        Sim::Advance(1000);
+        --ms;
+    }
+}
+
+void delayMicroseconds(unsigned int us) {
+    Sim::MutableStats().delay_us += us;
+    Sim::Advance(us);
+}
+
+void yield(void) {}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin < kNumPins) {
+        pin_modes[pin]  = mode;
+        pin_levels[pin] = (mode == INPUT_PULLUP) ? HIGH : pin_levels[pin];
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+    if (pin < kNumPins) {
+        pin_levels[pin] = val ? HIGH : LOW;
+    }
+}
+
+int digitalRead(uint8_t pin) {
+    if (digitalPinToInterrupt(pin) != NOT_AN_INTERRUPT) {
+        return Sim::GetInterruptPin(pin) ? HIGH : LOW;
+    }
+    return pin < kNumPins ? pin_levels[pin] : LOW;
+}
+
+int analogRead(uint8_t) {
+    return 0;
+}
+
+void attachInterrupt(uint8_t interrupt_num, void (*user_func)(void), int mode) {
+    Sim::AttachInterrupt(interrupt_num, user_func, mode);
+}
+
+void detachInterrupt(uint8_t interrupt_num) {
+    Sim::DetachInterrupt(interrupt_num);
+}
+
+long random(long howbig) {
+    if (howbig == 0) {
+        return 0;
+    }
+    return ::random() % howbig;
+}
+
+long random(long howsmall, long howbig) {
+    if (howsmall >= howbig) {
+        return howsmall;
+    }
+    return random(howbig - howsmall) + howsmall;
+}
+
+void randomSeed(unsigned long seed) {
+    if (seed != 0) {
+        srandom(static_cast<unsigned int>(seed));
+    }
+}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
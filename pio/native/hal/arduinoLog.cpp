@@ -0,0 +1,117 @@
+#include "ArduinoLog.h"
+
+Logging Log;
+
+void Logging::begin(int level, Print * output, bool show_level) {
+#ifndef DISABLE_LOGGING
+    level_      = constrain(level, LOG_LEVEL_SILENT, LOG_LEVEL_VERBOSE);
+    output_     = output;
+    show_level_ = show_level;
+#endif
+}
+
+void Logging::PrintLevel(int level, const char * msg, ...) {
+    va_list args;
+    va_start(args, msg);
+    VPrintLevel(level, msg, &args);
+    va_end(args);
+}
+
+void Logging::PrintLevel(int level, const __FlashStringHelper * msg, ...) {
+    va_list args;
+    va_start(args, msg);
+    VPrintLevel(level, reinterpret_cast<const char *>(msg), &args);
+    va_end(args);
+}
+
+void Logging::VPrintLevel(int level, const char * msg, va_list * args) {
+#ifndef DISABLE_LOGGING
+    if (output_ == nullptr || level > level_) {
+        return;
+    }
+
+    if (show_level_) {
+        static const char kLevels[] = "FEWNTV";
+        output_->print(kLevels[level - 1]);
+        output_->print(": ");
+    }
+
+    if (prefix_ != nullptr) {
+        prefix_(output_);
+    }
+
+    for (; *msg != '\0'; ++msg) {
+        if (*msg == '%') {
+            ++msg;
+            PrintFormat(*msg, args);
+            if (*msg == '\0') {
+                break;
+            }
+        } else {
+            output_->print(*msg);
+        }
+    }
+
+    if (suffix_ != nullptr) {
+        suffix_(output_);
+    }
+#else
+    (void)level;
+    (void)msg;
+    (void)args;
+#endif
+}
+
+void Logging::PrintFormat(char format, va_list * args) {
+    switch (format) {
+        case '\0':
+            return;
+        case '%':
+            output_->print(format);
+            break;
+        case 's':
+            output_->print(va_arg(*args, char *));
+            break;
+        case 'S':
+            output_->print(va_arg(*args, const __FlashStringHelper *));
+            break;
+        case 'd':
+        case 'i':
+            output_->print(va_arg(*args, int), DEC);
+            break;
+        case 'D':
+        case 'F':
+            output_->print(va_arg(*args, double));
+            break;
+        case 'x':
+            output_->print(va_arg(*args, int), HEX);
+            break;
+        case 'X':
+            output_->print("0x");
+            output_->print(va_arg(*args, int), HEX);
+            break;
+        case 'b':
+            output_->print(va_arg(*args, int), BIN);
+            break;
+        case 'B':
+            output_->print("0b");
+            output_->print(va_arg(*args, int), BIN);
+            break;
+        case 'l':
+            output_->print(va_arg(*args, long), DEC);
+            break;
+        case 'c':
+            output_->print(static_cast<char>(va_arg(*args, int)));
+            break;
+        case 't':
+            output_->print(va_arg(*args, int) == 1 ? "T" : "F");
+            break;
+        case 'T':
+            output_->print(va_arg(*args, int) == 1 ? "true" : "false");
+            break;
+        default:
+            output_->print('%');
+            output_->print(format);
+            break;
+    }
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <avr/io.h>
+
+// Interrupts are delivered synchronously by the models, so masking only
+// tracks the global interrupt flag.
+#define cli() (SREG &= static_cast<uint8_t>(~_BV(SREG_I)))
+#define sei() (SREG |= static_cast<uint8_t>(_BV(SREG_I)))
+
+// Vectors are plain functions; a model calls them when the interrupt fires.
+#define ISR(vector, ...) extern "C" void vector(void)
+
+extern "C" void ADC_vect(void) __attribute__((weak));
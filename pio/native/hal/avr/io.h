@@ -0,0 +1,108 @@
+#pragma once
+
+// ATmega328P registers that the firmware touches directly, backed by the
+// simulation models instead of memory-mapped I/O.
+
+#include <stdint.h>
+
+#define _BV(bit) (1 << (bit))
+#define bit_is_set(sfr, bit) ((sfr) & _BV(bit))
+#define bit_is_clear(sfr, bit) (!((sfr) & _BV(bit)))
+#define loop_until_bit_is_set(sfr, bit) \
+    do {                                \
+    } while (bit_is_clear(sfr, bit))
+#define loop_until_bit_is_clear(sfr, bit) \
+    do {                                  \
+    } while (bit_is_set(sfr, bit))
+
+namespace Sim {
+
+// An 8-bit I/O register; reads and writes are forwarded to the owning model.
+class Register {
+  public:
+    typedef void (*WriteHook)(Register & reg, uint8_t previous);
+    typedef void (*ReadHook)(Register & reg);
+
+    explicit Register(WriteHook on_write = nullptr, ReadHook on_read = nullptr)
+        : value_(0), on_write_(on_write), on_read_(on_read) {}
+
+    operator uint8_t(void) {
+        if (on_read_ != nullptr) {
+            on_read_(*this);
+        }
+        return value_;
+    }
+
+    Register & operator=(uint8_t value) {
+        uint8_t previous = value_;
+        value_           = value;
+        if (on_write_ != nullptr) {
+            on_write_(*this, previous);
+        }
+        return *this;
+    }
+
+    Register & operator|=(uint8_t value) { return *this = static_cast<uint8_t>(value_ | value); }
+    Register & operator&=(uint8_t value) { return *this = static_cast<uint8_t>(value_ & value); }
+    Register & operator^=(uint8_t value) { return *this = static_cast<uint8_t>(value_ ^ value); }
+
+    // Update the value from the model side without triggering the write hook.
+    void    Set(uint8_t value) { value_ = value; }
+    uint8_t Get(void) const { return value_; }
+
+  private:
+    uint8_t   value_;
+    WriteHook on_write_;
+    ReadHook  on_read_;
+};
+
+}  // namespace Sim
+
+// ADC
+extern Sim::Register ADMUX;
+extern Sim::Register ADCSRA;
+extern Sim::Register ADCSRB;
+extern Sim::Register ADCL;
+extern Sim::Register ADCH;
+
+// Status, sleep and power reduction
+extern Sim::Register SREG;
+extern Sim::Register SMCR;
+extern Sim::Register PRR;
+
+// ADMUX
+#define MUX0 0
+#define MUX1 1
+#define MUX2 2
+#define MUX3 3
+#define ADLAR 5
+#define REFS0 6
+#define REFS1 7
+
+// ADCSRA
+#define ADPS0 0
+#define ADPS1 1
+#define ADPS2 2
+#define ADIE 3
+#define ADIF 4
+#define ADATE 5
+#define ADSC 6
+#define ADEN 7
+
+// SMCR
+#define SE 0
+#define SM0 1
+#define SM1 2
+#define SM2 3
+
+// PRR
+#define PRADC 0
+#define PRUSART0 1
+#define PRSPI 2
+#define PRTIM1 3
+#define PRTIM0 5
+#define PRTIM2 6
+#define PRTWI 7
+
+// SREG
+#define SREG_I 7
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <avr/io.h>
+
+#include "sim.h"
+
+#define SLEEP_MODE_IDLE (0)
+#define SLEEP_MODE_ADC _BV(SM0)
+#define SLEEP_MODE_PWR_DOWN _BV(SM1)
+#define SLEEP_MODE_PWR_SAVE (_BV(SM0) | _BV(SM1))
+#define SLEEP_MODE_STANDBY (_BV(SM1) | _BV(SM2))
+#define SLEEP_MODE_EXT_STANDBY (_BV(SM0) | _BV(SM1) | _BV(SM2))
+
+#define set_sleep_mode(mode) (SMCR = static_cast<uint8_t>((SMCR & ~(_BV(SM0) | _BV(SM1) | _BV(SM2))) | (mode)))
+#define sleep_enable() (SMCR |= _BV(SE))
+#define sleep_disable() (SMCR &= static_cast<uint8_t>(~_BV(SE)))
+
+// The CPU only halts when sleep is enabled, exactly like the `sleep` instruction.
+#define sleep_cpu()                                                         \
+    do {                                                                    \
+        if (SMCR & _BV(SE)) {                                               \
+            Sim::Sleep(static_cast<uint8_t>(SMCR & (_BV(SM0) | _BV(SM1) | _BV(SM2)))); \
+        }                                                                   \
+    } while (0)
+
+#define sleep_mode()     \
+    do {                 \
+        sleep_enable();  \
+        sleep_cpu();     \
+        sleep_disable(); \
+    } while (0)
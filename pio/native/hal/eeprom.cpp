@@ -0,0 +1,70 @@
+#include <EEPROM.h>
+
+#include "sim.h"
+#include "simModels.h"
+
+EEPROMClass EEPROM;
+
+namespace {
+
+const uint16_t kEepromSize = 1024;
+const uint32_t kWriteUs    = 3400;
+
+uint8_t  contents[kEepromSize];
+uint64_t write_done_us = 0;
+
+}  // namespace
+
+uint8_t EEPROMClass::read(int index) {
+    if (index < 0 || index >= kEepromSize) {
+        return 0xFF;
+    }
+
+    // Reading also waits for a write in progress.
+    if (Sim::Now() < write_done_us) {
+        Sim::Advance(static_cast<uint32_t>(write_done_us - Sim::Now()));
+    }
+    return contents[index];
+}
+
+void EEPROMClass::write(int index, uint8_t value) {
+    if (index < 0 || index >= kEepromSize) {
+        return;
+    }
+
+    if (Sim::Now() < write_done_us) {
+        Sim::Advance(static_cast<uint32_t>(write_done_us - Sim::Now()));
+    }
+    contents[index] = value;
+    write_done_us   = Sim::Now() + kWriteUs;
+    ++Sim::MutableStats().eeprom_writes;
+}
+
+void EEPROMClass::update(int index, uint8_t value) {
+    if (read(index) != value) {
+        write(index, value);
+    }
+}
+
+uint16_t EEPROMClass::length(void) const {
+    return kEepromSize;
+}
+
+namespace Sim {
+
+void ResetEeprom(void) {
+    for (uint16_t i = 0; i < kEepromSize; ++i) {
+        contents[i] = 0xFF;
+    }
+    write_done_us = 0;
+}
+
+uint8_t * GetEeprom(void) {
+    return contents;
+}
+
+uint16_t GetEepromSize(void) {
+    return kEepromSize;
+}
+
+}  // namespace Sim
@@ -0,0 +1,141 @@
+#include <FastLED.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "sim.h"
+#include "simModels.h"
+
+CLEDController * CLEDController::m_pHead = NULL;
+CLEDController * CLEDController::m_pTail = NULL;
+
+CFastLED FastLED;
+
+// colorutils' 2D blurs call a sketch-provided `XY()`; the AVR link drops them
+// when unused, the host link needs a definition.
+__attribute__((weak)) uint16_t XY(uint8_t x, uint8_t y) {
+    (void)x;
+    (void)y;
+    return 0;
+}
+
+void SimController::showColor(const struct CRGB & data, int nLeds, CRGB scale) {
+    std::vector<CRGB> frame(nLeds, data);
+    show(frame.data(), nLeds, scale);
+}
+
+void SimController::show(const struct CRGB * data, int nLeds, CRGB scale) {
+    if (strip_.size() < 3U * nLeds) {
+        strip_.resize(3 * nLeds);
+    }
+    for (int i = 0; i < nLeds; ++i) {
+        strip_[3 * i]     = scale8(data[i].r, scale.r);
+        strip_[3 * i + 1] = scale8(data[i].g, scale.g);
+        strip_[3 * i + 2] = scale8(data[i].b, scale.b);
+    }
+
+    Sim::FrameSink & sink = Sim::GetFrameSink();
+    if (sink) {
+        sink(Sim::Now(), strip_.data(), static_cast<int>(strip_.size() / 3), scale.r);
+    }
+
+    uint32_t us = WS2812_US_PER_LED * nLeds + WS2812_LATCH_US;
+
+    Sim::Stats & stats = Sim::MutableStats();
+    ++stats.frames_shown;
+    stats.led_bytes_shown += 3 * nLeds;
+    stats.led_us += us;
+    stats.led_peak_ma = std::max(
+        stats.led_peak_ma,
+        calculate_unscaled_power_mW(reinterpret_cast<const CRGB *>(strip_.data()), strip_.size() / 3) / 5);
+
+    Sim::Advance(us);
+}
+
+CFastLED::CFastLED(void) : m_Scale(255), m_nMinMicros(0), m_nPowerData(0xFFFFFFFF), m_pPowerFunc(NULL), lastshow(0) {}
+
+CLEDController & CFastLED::addLeds(CLEDController * pLed, struct CRGB * data, int nLedsOrOffset, int nLedsIfOffset) {
+    int nOffset = (nLedsIfOffset > 0) ? nLedsOrOffset : 0;
+    int nLeds   = (nLedsIfOffset > 0) ? nLedsIfOffset : nLedsOrOffset;
+
+    pLed->init();
+    pLed->setLeds(data + nOffset, nLeds);
+    FastLED.setMaxRefreshRate(pLed->getMaxRefreshRate(), true);
+    return *pLed;
+}
+
+void CFastLED::show(uint8_t scale) {
+    // Guard against showing too rapidly; the device spins here.
+    uint32_t since_last_show = micros() - lastshow;
+    if (m_nMinMicros && since_last_show < m_nMinMicros) {
+        Sim::Advance(m_nMinMicros - since_last_show);
+    }
+    lastshow = micros();
+
+    if (m_pPowerFunc) {
+        scale = (*m_pPowerFunc)(scale, m_nPowerData);
+    }
+
+    CLEDController * pCur = CLEDController::head();
+    while (pCur) {
+        pCur->showLeds(scale);
+        pCur = pCur->next();
+    }
+}
+
+void CFastLED::clear(bool writeData) {
+    if (writeData) {
+        CLEDController * pCur = CLEDController::head();
+        while (pCur) {
+            pCur->showColor(CRGB::Black, 0);
+            pCur = pCur->next();
+        }
+    }
+    clearData();
+}
+
+void CFastLED::clearData() {
+    CLEDController * pCur = CLEDController::head();
+    while (pCur) {
+        pCur->clearLedData();
+        pCur = pCur->next();
+    }
+}
+
+void CFastLED::delay(unsigned long ms) {
+    unsigned long start = millis();
+    do {
+        ::delay(1);
+        show();
+    } while ((millis() - start) < ms);
+}
+
+void CFastLED::setMaxRefreshRate(uint16_t refresh, bool constrain) {
+    if (constrain) {
+        if (refresh > 0) {
+            m_nMinMicros = ((1000000 / refresh) > m_nMinMicros) ? (1000000 / refresh) : m_nMinMicros;
+        }
+    } else if (refresh > 0) {
+        m_nMinMicros = 1000000 / refresh;
+    } else {
+        m_nMinMicros = 0;
+    }
+}
+
+int CFastLED::count() {
+    int              x    = 0;
+    CLEDController * pCur = CLEDController::head();
+    while (pCur) {
+        ++x;
+        pCur = pCur->next();
+    }
+    return x;
+}
+
+CLEDController & CFastLED::operator[](int x) {
+    CLEDController * pCur = CLEDController::head();
+    while (x-- && pCur) {
+        pCur = pCur->next();
+    }
+    return pCur == NULL ? *(CLEDController::head()) : *pCur;
+}
@@ -0,0 +1,89 @@
+#include "HardwareSerial.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "sim.h"
+#include "simModels.h"
+
+HardwareSerial Serial;
+
+namespace {
+
+bool echo = false;
+
+const char * input = "";
+
+}  // namespace
+
+namespace Sim {
+
+void SetSerialEcho(bool enabled) {
+    echo = enabled;
+}
+
+void SetSerialInput(const char * bytes) {
+    input = bytes;
+}
+
+}  // namespace Sim
+
+void HardwareSerial::begin(unsigned long baud) {
+    baud_          = baud;
+    tx_busy_until_ = Sim::Now();
+}
+
+void HardwareSerial::end(void) {
+    flush();
+}
+
+int HardwareSerial::available(void) {
+    return static_cast<int>(strlen(input));
+}
+
+int HardwareSerial::read(void) {
+    int c = peek();
+    if (c != -1) {
+        ++input;
+    }
+    return c;
+}
+
+int HardwareSerial::peek(void) {
+    return *input != '\0' ? static_cast<uint8_t>(*input) : -1;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    // Start bit, 8 data bits, stop bit.
+    uint64_t byte_us = (10ULL * 1000000ULL + baud_ / 2) / baud_;
+    uint64_t now     = Sim::Now();
+
+    tx_busy_until_ = (tx_busy_until_ > now ? tx_busy_until_ : now) + byte_us;
+
+    // Block while the transmit buffer is full.
+    uint64_t buffered_us = kTxBufferSize * byte_us;
+    if (tx_busy_until_ - now > buffered_us) {
+        uint64_t wait_us = tx_busy_until_ - now - buffered_us;
+        Sim::MutableStats().serial_us += wait_us;
+        Sim::Advance(static_cast<uint32_t>(wait_us));
+    }
+
+    ++Sim::MutableStats().serial_bytes;
+
+    if (echo) {
+        fputc(c, stdout);
+    }
+
+    return 1;
+}
+
+void HardwareSerial::flush(void) {
+    uint64_t now = Sim::Now();
+    if (tx_busy_until_ > now) {
+        Sim::MutableStats().serial_us += tx_busy_until_ - now;
+        Sim::Advance(static_cast<uint32_t>(tx_busy_until_ - now));
+    }
+    if (echo) {
+        fflush(stdout);
+    }
+}
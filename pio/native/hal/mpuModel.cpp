@@ -0,0 +1,605 @@
+#include "mpuModel.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "sim.h"
+#include "simModels.h"
+
+namespace Sim {
+
+namespace {
+
+// Register addresses, from the MPU-6000/MPU-6050 Register Map rev 4.2.
+const uint8_t kSmplrtDiv      = 0x19;
+const uint8_t kConfig         = 0x1A;
+const uint8_t kGyroConfig     = 0x1B;
+const uint8_t kAccelConfig    = 0x1C;
+const uint8_t kFfThr          = 0x1D;
+const uint8_t kFfDur          = 0x1E;
+const uint8_t kMotThr         = 0x1F;
+const uint8_t kMotDur         = 0x20;
+const uint8_t kZrmotThr       = 0x21;
+const uint8_t kZrmotDur       = 0x22;
+const uint8_t kFifoEn         = 0x23;
+const uint8_t kIntPinCfg      = 0x37;
+const uint8_t kIntEnable      = 0x38;
+const uint8_t kIntStatus      = 0x3A;
+const uint8_t kAccelXoutH     = 0x3B;
+const uint8_t kTempOutH       = 0x41;
+const uint8_t kGyroXoutH      = 0x43;
+const uint8_t kMotDetectStatus = 0x61;
+const uint8_t kUserCtrl       = 0x6A;
+const uint8_t kPwrMgmt1       = 0x6B;
+const uint8_t kPwrMgmt2       = 0x6C;
+const uint8_t kBankSel        = 0x6D;
+const uint8_t kMemStartAddr   = 0x6E;
+const uint8_t kMemRW          = 0x6F;
+const uint8_t kFifoCountH     = 0x72;
+const uint8_t kFifoCountL     = 0x73;
+const uint8_t kFifoRW         = 0x74;
+const uint8_t kWhoAmI         = 0x75;
+
+// INT_STATUS / INT_ENABLE bits.
+const uint8_t kIntFreefall   = 7;
+const uint8_t kIntMotion     = 6;
+const uint8_t kIntZeroMotion = 5;
+const uint8_t kIntFifoOflow  = 4;
+const uint8_t kIntDmp        = 1;
+const uint8_t kIntDataReady  = 0;
+
+// USER_CTRL bits.
+const uint8_t kDmpEnabled  = 0x80;
+const uint8_t kFifoEnabled = 0x40;
+const uint8_t kDmpReset    = 0x08;
+
+// Where MotionApps 2.0 keeps the FIFO rate divider, D_0_22, big-endian.
+const uint16_t kDmpFifoRateAddress = 2 * 256 + 0x16;
+
+// The largest sample the firmware reads from the FIFO outside the DMP, accel
+// and gyro.
+const uint16_t kMaxFifoSampleBytes = 12;
+
+// How long the modelled DMP takes to pull its estimate to the accelerometer.
+const float kDmpAccelTimeConstantS = 0.5f;
+
+const float kGyroLsbPerRadPerSec = 131.f * 180.f / static_cast<float>(M_PI);
+
+// Motion thresholds are 2mg per LSB, i.e. 32.768 LSB at ±2g.
+const float kThresholdLsb = 32.768f;
+
+// Roughly 36.53°C, the datasheet offset for a zero reading.
+const int16_t kTemperature = 0;
+
+// The Stecchino PCB wires the MPU INT output to D3, external interrupt 1.
+const uint8_t kInterruptPin = 3;
+
+// Cutoff frequency in Hz of the digital high-pass filter, by ACCEL_HPF setting.
+float HighPassCutoff(uint8_t mode) {
+    switch (mode) {
+        case 1:
+            return 5.f;
+        case 2:
+            return 2.5f;
+        case 3:
+            return 1.25f;
+        case 4:
+            return 0.63f;
+        default:
+            return 0.f;
+    }
+}
+
+int16_t Saturate(int32_t value) {
+    if (value > INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (value < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return static_cast<int16_t>(value);
+}
+
+void PutWord(uint8_t * destination, int16_t value) {
+    destination[0] = static_cast<uint8_t>(static_cast<uint16_t>(value) >> 8);
+    destination[1] = static_cast<uint8_t>(value & 0xFF);
+}
+
+void PutLong(uint8_t * destination, int32_t value) {
+    PutWord(destination, static_cast<int16_t>(value >> 16));
+    PutWord(destination + 2, static_cast<int16_t>(value & 0xFFFF));
+}
+
+}  // namespace
+
+MpuModel::MpuModel(void) {
+    Reset();
+}
+
+void MpuModel::Reset(void) {
+    memset(registers_, 0, sizeof(registers_));
+    registers_[kPwrMgmt1] = 0x40;  // Sleep until woken by the driver.
+    registers_[kWhoAmI]   = 0x68;
+
+    register_pointer_ = 0;
+    fifo_head_        = 0;
+    fifo_count_       = 0;
+    next_sample_us_   = 0;
+    next_engine_us_   = 0;
+    metered_us_       = Now();
+
+    for (int i = 0; i < 3; ++i) {
+        high_pass_reference_[i] = 0.f;
+    }
+    motion_ms_      = 0;
+    zero_motion_ms_ = 0;
+    free_fall_ms_   = 0;
+    zero_motion_    = false;
+    pulse_pending_  = false;
+
+    memset(dmp_memory_, 0, sizeof(dmp_memory_));
+    dmp_fused_   = false;
+    dmp_samples_ = 0;
+}
+
+void MpuModel::Receive(const uint8_t * data, uint8_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    Tick();
+
+    register_pointer_ = data[0] & 0x7F;
+    for (uint8_t i = 1; i < count; ++i) {
+        Write(register_pointer_, data[i]);
+        if (register_pointer_ != kFifoRW && register_pointer_ != kMemRW) {
+            register_pointer_ = (register_pointer_ + 1) & 0x7F;
+        }
+    }
+}
+
+uint8_t MpuModel::Transmit(uint8_t * data, uint8_t count) {
+    Tick();
+
+    for (uint8_t i = 0; i < count; ++i) {
+        data[i] = Read(register_pointer_);
+        if (register_pointer_ != kFifoRW && register_pointer_ != kMemRW) {
+            register_pointer_ = (register_pointer_ + 1) & 0x7F;
+        }
+    }
+
+    UpdatePin();
+
+    return count;
+}
+
+uint8_t MpuModel::Read(uint8_t reg) {
+    switch (reg) {
+        case kIntStatus: {
+            uint8_t status        = registers_[kIntStatus];
+            registers_[kIntStatus] = 0;
+            return status;
+        }
+
+        case kFifoCountH:
+            return static_cast<uint8_t>(fifo_count_ >> 8);
+
+        case kFifoCountL:
+            return static_cast<uint8_t>(fifo_count_ & 0xFF);
+
+        case kFifoRW: {
+            if (fifo_count_ == 0) {
+                return 0;
+            }
+            uint16_t tail = (fifo_head_ + kFifoCapacity - fifo_count_) % kFifoCapacity;
+            --fifo_count_;
+            return fifo_[tail];
+        }
+
+        case kMemRW: {
+            // Banks past the DMP's, such as the hardware revision, read as 0.
+            uint16_t address = 256 * (registers_[kBankSel] & 0x1F) + registers_[kMemStartAddr]++;
+            return address < kDmpMemorySize ? dmp_memory_[address] : 0;
+        }
+
+        default:
+            return registers_[reg];
+    }
+}
+
+void MpuModel::Write(uint8_t reg, uint8_t value) {
+    switch (reg) {
+        case kIntStatus:
+        case kFifoCountH:
+        case kFifoCountL:
+        case kWhoAmI:
+            // Read-only.
+            break;
+
+        case kFifoRW:
+            PushFifo(value);
+            break;
+
+        case kMemRW: {
+            uint16_t address = 256 * (registers_[kBankSel] & 0x1F) + registers_[kMemStartAddr]++;
+            if (address < kDmpMemorySize) {
+                dmp_memory_[address] = value;
+            }
+        } break;
+
+        case kUserCtrl:
+            if (value & 0x04) {
+                // The firmware resets it with no room left for another
+                // sample, a full one was counted as it filled.
+                if (fifo_count_ > kFifoCapacity - kMaxFifoSampleBytes && fifo_count_ < kFifoCapacity) {
+                    ++MutableStats().fifo_overflows;
+                }
+                // FIFO_RESET self-clears.
+                fifo_head_  = 0;
+                fifo_count_ = 0;
+                value &= static_cast<uint8_t>(~0x04);
+            }
+            if (value & kDmpReset) {
+                dmp_fused_   = false;
+                dmp_samples_ = 0;
+            }
+            registers_[reg] = value & static_cast<uint8_t>(~0x0B);
+            break;
+
+        case kPwrMgmt1:
+            if (value & 0x80) {
+                Reset();
+                return;
+            }
+            registers_[reg] = value;
+            next_sample_us_ = Now();
+            next_engine_us_ = Now();
+            break;
+
+        default:
+            registers_[reg] = value;
+            break;
+    }
+}
+
+uint32_t MpuModel::GetSamplePeriodUs(void) const {
+    if (registers_[kPwrMgmt1] & 0x20) {
+        // Low-power accelerometer cycle mode, LP_WAKE_CTRL.
+        static const uint32_t kWakePeriodUs[] = {800000, 200000, 50000, 25000};
+        return kWakePeriodUs[registers_[kPwrMgmt2] >> 6];
+    }
+
+    uint8_t  dlpf             = registers_[kConfig] & 0x07;
+    uint32_t gyro_output_rate = (dlpf == 0 || dlpf == 7) ? 8000 : 1000;
+    return 1000000UL * (1 + registers_[kSmplrtDiv]) / gyro_output_rate;
+}
+
+uint16_t MpuModel::GetCurrentUa(void) const {
+    if (registers_[kPwrMgmt1] & 0x40) {
+        return 5;
+    }
+    if (registers_[kPwrMgmt1] & 0x20) {
+        // The accelerometer alone, by LP_WAKE_CTRL.
+        static const uint16_t kCycleUa[] = {10, 20, 70, 140};
+        return kCycleUa[registers_[kPwrMgmt2] >> 6];
+    }
+
+    // 3.9mA with everything on, of which the accelerometer takes 500uA, and
+    // the sleep current with both in standby.
+    bool     gyro    = (registers_[kPwrMgmt2] & 0x07) != 0x07;
+    bool     accel   = (registers_[kPwrMgmt2] & 0x38) != 0x38;
+    uint16_t current = 0;
+    if (gyro) {
+        current += 3400;
+    }
+    if (accel) {
+        current += 500;
+    }
+    return current > 0 ? current : 5;
+}
+
+void MpuModel::Tick(void) {
+    uint64_t now      = Now();
+    bool     sleeping = (registers_[kPwrMgmt1] & 0x40) != 0;
+
+    // Each register access ticks first, so the mode has held since the last tick.
+    if (now > metered_us_) {
+        MutableStats().mpu_ua_us += (now - metered_us_) * GetCurrentUa();
+        metered_us_ = now;
+    }
+
+    if (sleeping) {
+        next_sample_us_ = now;
+        next_engine_us_ = now;
+        return;
+    }
+
+    bool     cycling   = (registers_[kPwrMgmt1] & 0x20) != 0;
+    uint32_t period_us = GetSamplePeriodUs();
+
+    // Interleave samples and 1ms motion-engine steps in time order so the
+    // interrupt status reflects what the chip would have raised by `now`.
+    while (next_sample_us_ <= now || (!cycling && next_engine_us_ <= now)) {
+        if (!cycling && next_engine_us_ <= next_sample_us_) {
+            RunMotionEngines(next_engine_us_);
+            next_engine_us_ += 1000;
+        } else {
+            Sample(next_sample_us_);
+            if (cycling) {
+                // In cycle mode the engines only run on each wake-up.
+                RunMotionEngines(next_sample_us_);
+            }
+            next_sample_us_ += period_us;
+        }
+    }
+
+    UpdatePin();
+}
+
+void MpuModel::Sample(uint64_t at) {
+    Motion  motion    = GetMotion(at);
+    uint8_t accel_fs  = (registers_[kAccelConfig] >> 3) & 0x03;
+    uint8_t gyro_fs   = (registers_[kGyroConfig] >> 3) & 0x03;
+    uint8_t standby   = registers_[kPwrMgmt2];
+    bool    cycling   = (registers_[kPwrMgmt1] & 0x20) != 0;
+
+    int16_t accel[3] = {
+        Saturate(motion.accel.x >> accel_fs),
+        Saturate(motion.accel.y >> accel_fs),
+        Saturate(motion.accel.z >> accel_fs),
+    };
+    int16_t gyro[3] = {
+        Saturate(motion.gyro.x >> gyro_fs),
+        Saturate(motion.gyro.y >> gyro_fs),
+        Saturate(motion.gyro.z >> gyro_fs),
+    };
+
+    for (int axis = 0; axis < 3; ++axis) {
+        if (standby & (0x20 >> axis)) {
+            accel[axis] = 0;
+        }
+        if (cycling || (standby & (0x04 >> axis))) {
+            gyro[axis] = 0;
+        }
+        PutWord(&registers_[kAccelXoutH + 2 * axis], accel[axis]);
+        PutWord(&registers_[kGyroXoutH + 2 * axis], gyro[axis]);
+    }
+    PutWord(&registers_[kTempOutH], kTemperature);
+
+    if ((registers_[kUserCtrl] & kDmpEnabled) && !cycling) {
+        RunDmp(accel, gyro, GetSamplePeriodUs());
+    }
+
+    uint8_t fifo_enabled = registers_[kFifoEn];
+    if (registers_[kUserCtrl] & kFifoEnabled) {
+        if (fifo_enabled & 0x08) {
+            for (int i = 0; i < 6; ++i) {
+                PushFifo(registers_[kAccelXoutH + i]);
+            }
+        }
+        if (fifo_enabled & 0x80) {
+            PushFifo(registers_[kTempOutH]);
+            PushFifo(registers_[kTempOutH + 1]);
+        }
+        for (int axis = 0; axis < 3; ++axis) {
+            if (fifo_enabled & (0x40 >> axis)) {
+                PushFifo(registers_[kGyroXoutH + 2 * axis]);
+                PushFifo(registers_[kGyroXoutH + 2 * axis + 1]);
+            }
+        }
+    }
+
+    RaiseInterrupt(kIntDataReady);
+}
+
+void MpuModel::RunDmp(const int16_t accel[3], const int16_t gyro[3], uint32_t period_us) {
+    uint8_t accel_fs = (registers_[kAccelConfig] >> 3) & 0x03;
+    uint8_t gyro_fs  = (registers_[kGyroConfig] >> 3) & 0x03;
+    float   dt       = period_us / 1e6f;
+
+    float measured[3];
+    float norm = 0.f;
+    for (int axis = 0; axis < 3; ++axis) {
+        measured[axis] = static_cast<float>(accel[axis]) * (1 << accel_fs);
+        norm += measured[axis] * measured[axis];
+    }
+    norm = sqrtf(norm);
+    if (norm > 0.f) {
+        for (int axis = 0; axis < 3; ++axis) {
+            measured[axis] /= norm;
+        }
+    }
+
+    float * g = dmp_gravity_;
+    if (!dmp_fused_) {
+        memcpy(g, measured, sizeof(measured));
+        dmp_fused_ = true;
+    } else {
+        float w[3];
+        for (int axis = 0; axis < 3; ++axis) {
+            w[axis] = static_cast<float>(gyro[axis]) * (1 << gyro_fs) / kGyroLsbPerRadPerSec;
+        }
+        // Gravity is fixed in the world, so the sensor sees it turn as g × ω.
+        float turned[3] = {
+            g[0] + (g[1] * w[2] - g[2] * w[1]) * dt,
+            g[1] + (g[2] * w[0] - g[0] * w[2]) * dt,
+            g[2] + (g[0] * w[1] - g[1] * w[0]) * dt,
+        };
+        float gain = dt / kDmpAccelTimeConstantS;
+        norm       = 0.f;
+        for (int axis = 0; axis < 3; ++axis) {
+            g[axis] = turned[axis] + gain * (measured[axis] - turned[axis]);
+            norm += g[axis] * g[axis];
+        }
+        norm = sqrtf(norm);
+        for (int axis = 0; axis < 3; ++axis) {
+            g[axis] /= norm;
+        }
+    }
+
+    uint16_t divider = (dmp_memory_[kDmpFifoRateAddress] << 8) | dmp_memory_[kDmpFifoRateAddress + 1];
+    if (++dmp_samples_ <= divider) {
+        return;
+    }
+    dmp_samples_ = 0;
+
+    if (!(registers_[kUserCtrl] & kFifoEnabled)) {
+        return;
+    }
+
+    // The rotation from the sensor's Z axis to gravity, which `dmpGetGravity()`
+    // turns back into `g`: about (g.y, -g.x, 0) by acos(g.z).
+    float angle  = acosf(fmaxf(-1.f, fminf(1.f, g[2])));
+    float sine   = sinf(angle);
+    float axis_x = sine > 1e-6f ? g[1] / sine : 1.f;
+    float axis_y = sine > 1e-6f ? -g[0] / sine : 0.f;
+    float half   = sinf(angle / 2.f);
+    float q[4]   = {cosf(angle / 2.f), axis_x * half, axis_y * half, 0.f};
+
+    uint8_t packet[kDmpPacketBytes] = {};
+    for (int i = 0; i < 4; ++i) {
+        // Q30.
+        PutLong(&packet[4 * i], static_cast<int32_t>(q[i] * 1073741823.f));
+    }
+    for (int axis = 0; axis < 3; ++axis) {
+        PutLong(&packet[16 + 4 * axis], static_cast<int32_t>(gyro[axis]) * 65536);
+        PutLong(&packet[28 + 4 * axis], static_cast<int32_t>(accel[axis]) * 65536);
+    }
+    for (uint8_t byte : packet) {
+        PushFifo(byte);
+    }
+
+    RaiseInterrupt(kIntDmp);
+}
+
+void MpuModel::PushFifo(uint8_t value) {
+    bool was_full = fifo_count_ == kFifoCapacity;
+    if (was_full) {
+        // The oldest byte is overwritten.
+        --fifo_count_;
+        RaiseInterrupt(kIntFifoOflow);
+    }
+    fifo_[fifo_head_] = value;
+    fifo_head_        = (fifo_head_ + 1) % kFifoCapacity;
+    ++fifo_count_;
+
+    if (!was_full && fifo_count_ == kFifoCapacity) {
+        ++MutableStats().fifo_overflows;
+    }
+}
+
+void MpuModel::RunMotionEngines(uint64_t at) {
+    Motion motion    = GetMotion(at);
+    float  cutoff_hz = HighPassCutoff(registers_[kAccelConfig] & 0x07);
+    float  alpha     = 1.f - expf(-2.f * static_cast<float>(M_PI) * cutoff_hz * 0.001f);
+    float  accel[3]  = {
+        static_cast<float>(motion.accel.x),
+        static_cast<float>(motion.accel.y),
+        static_cast<float>(motion.accel.z),
+    };
+
+    bool moving     = false;
+    bool still      = true;
+    bool free_fall  = true;
+
+    for (int axis = 0; axis < 3; ++axis) {
+        float high_passed = 0.f;
+        if ((registers_[kAccelConfig] & 0x07) == 7) {
+            // Hold: compare against the sample latched when HOLD was selected.
+            high_passed = accel[axis] - high_pass_reference_[axis];
+        } else if (cutoff_hz > 0.f) {
+            high_pass_reference_[axis] += alpha * (accel[axis] - high_pass_reference_[axis]);
+            high_passed = accel[axis] - high_pass_reference_[axis];
+        } else {
+            high_pass_reference_[axis] = accel[axis];
+        }
+
+        if (fabsf(high_passed) > registers_[kMotThr] * kThresholdLsb) {
+            moving = true;
+        }
+        if (fabsf(high_passed) > registers_[kZrmotThr] * kThresholdLsb) {
+            still = false;
+        }
+        if (fabsf(accel[axis]) > registers_[kFfThr] * kThresholdLsb) {
+            free_fall = false;
+        }
+    }
+
+    // Motion: any axis above MOT_THR for MOT_DUR ms.
+    if (moving) {
+        if (motion_ms_ < UINT16_MAX) {
+            ++motion_ms_;
+        }
+        if (motion_ms_ == static_cast<uint16_t>(registers_[kMotDur]) + 1) {
+            RaiseInterrupt(kIntMotion);
+        }
+    } else {
+        motion_ms_ = 0;
+    }
+
+    // Zero motion: all axes below ZRMOT_THR for ZRMOT_DUR * 64 ms, signalled
+    // on entry and again on exit.
+    if (still) {
+        if (zero_motion_ms_ < UINT16_MAX) {
+            ++zero_motion_ms_;
+        }
+        if (!zero_motion_ && zero_motion_ms_ >= static_cast<uint16_t>(registers_[kZrmotDur]) * 64 + 1) {
+            zero_motion_ = true;
+            registers_[kMotDetectStatus] |= 0x01;
+            RaiseInterrupt(kIntZeroMotion);
+        }
+    } else {
+        zero_motion_ms_ = 0;
+        if (zero_motion_) {
+            zero_motion_ = false;
+            registers_[kMotDetectStatus] &= static_cast<uint8_t>(~0x01);
+            RaiseInterrupt(kIntZeroMotion);
+        }
+    }
+
+    // Free fall: all axes below FF_THR for FF_DUR ms.
+    if (free_fall && registers_[kFfThr] > 0) {
+        if (free_fall_ms_ < UINT16_MAX) {
+            ++free_fall_ms_;
+        }
+        if (free_fall_ms_ == static_cast<uint16_t>(registers_[kFfDur]) + 1) {
+            RaiseInterrupt(kIntFreefall);
+        }
+    } else {
+        free_fall_ms_ = 0;
+    }
+}
+
+void MpuModel::RaiseInterrupt(uint8_t bit) {
+    registers_[kIntStatus] |= static_cast<uint8_t>(1 << bit);
+    if (registers_[kIntEnable] & (1 << bit)) {
+        pulse_pending_ = true;
+    }
+}
+
+bool MpuModel::GetInterruptLevel(void) const {
+    bool latched    = (registers_[kIntPinCfg] & 0x20) != 0;
+    bool asserted   = latched ? (registers_[kIntStatus] & registers_[kIntEnable]) != 0 : pulse_pending_;
+    bool active_low = (registers_[kIntPinCfg] & 0x80) != 0;
+    return asserted != active_low;
+}
+
+void MpuModel::UpdatePin(void) {
+    SetInterruptPin(kInterruptPin, GetInterruptLevel());
+
+    // Without LATCH_INT_EN the pin only pulses for 50us, well under one model
+    // step, so it is released again straight away.
+    if (pulse_pending_) {
+        pulse_pending_ = false;
+        if (!(registers_[kIntPinCfg] & 0x20)) {
+            SetInterruptPin(kInterruptPin, GetInterruptLevel());
+        }
+    }
+}
+
+MpuModel & GetMpuModel(void) {
+    static MpuModel model;
+    return model;
+}
+
+}  // namespace Sim
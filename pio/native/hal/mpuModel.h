@@ -0,0 +1,97 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <Wire.h>
+
+namespace Sim {
+
+// Register-level model of an MPU6050 at address 0x68.
+//
+// The vendored I2Cdevlib driver talks to it through the Wire model, so the
+// firmware exercises the real `MPU6050` class. Sensor registers and the FIFO
+// are filled from the motion source at the configured sample rate, and the
+// data-ready, FIFO overflow, motion, zero-motion and free-fall engines raise
+// INT_STATUS bits and drive the INT pin the way the datasheet describes.
+//
+// The DMP is modelled from the outside: its memory banks hold whatever the
+// driver loads, and once enabled it fuses each sample into a gravity estimate
+// and queues MotionApps 2.0 packets, at the FIFO rate set in its memory. The
+// fusion is a complementary filter, the gyro turning the estimate and the
+// accelerometer pulling it back over `kDmpAccelTimeConstantS`, as the DMP's
+// own algorithm is undocumented.
+class MpuModel : public I2cDevice {
+  public:
+    static const uint8_t  kAddress        = 0x68;
+    static const uint16_t kFifoCapacity   = 1024;
+    static const uint16_t kDmpMemorySize  = 8 * 256;
+    static const uint8_t  kDmpPacketBytes = 42;
+
+    MpuModel(void);
+
+    void Reset(void);
+
+    void    Receive(const uint8_t * data, uint8_t count) override;
+    uint8_t Transmit(uint8_t * data, uint8_t count) override;
+
+    // Run the sample clock up to the current simulated time.
+    void Tick(void);
+
+    // Level of the INT pin, honouring INT_LEVEL.
+    bool GetInterruptLevel(void) const;
+
+    // Current sample period in microseconds, including low-power cycle mode.
+    uint32_t GetSamplePeriodUs(void) const;
+
+    // Supply current of the power mode and the sensors out of standby, from
+    // the datasheet.
+    uint16_t GetCurrentUa(void) const;
+
+    uint16_t GetFifoCount(void) const { return fifo_count_; }
+
+  private:
+    uint8_t registers_[128];
+    uint8_t register_pointer_;
+
+    uint8_t  fifo_[kFifoCapacity];
+    uint16_t fifo_head_;
+    uint16_t fifo_count_;
+
+    uint64_t next_sample_us_;
+    uint64_t next_engine_us_;
+
+    // Up to when the current has been counted into the stats.
+    uint64_t metered_us_;
+
+    // Motion engines state, stepped once per millisecond.
+    float    high_pass_reference_[3];
+    uint16_t motion_ms_;
+    uint16_t zero_motion_ms_;
+    uint16_t free_fall_ms_;
+    bool     zero_motion_;
+
+    // An enabled interrupt was raised since the pin was last updated.
+    bool pulse_pending_;
+
+    uint8_t dmp_memory_[kDmpMemorySize];
+
+    // Unit gravity vector in the sensor frame, none until the first sample
+    // after a DMP reset.
+    float    dmp_gravity_[3];
+    bool     dmp_fused_;
+    uint16_t dmp_samples_;
+
+    uint8_t Read(uint8_t reg);
+    void    Write(uint8_t reg, uint8_t value);
+
+    void Sample(uint64_t at);
+    void RunDmp(const int16_t accel[3], const int16_t gyro[3], uint32_t period_us);
+    void PushFifo(uint8_t value);
+    void RunMotionEngines(uint64_t at);
+    void RaiseInterrupt(uint8_t bit);
+    void UpdatePin(void);
+};
+
+MpuModel & GetMpuModel(void);
+
+}  // namespace Sim
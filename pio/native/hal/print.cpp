@@ -0,0 +1,165 @@
+#include "Print.h"
+
+#include <math.h>
+#include <string.h>
+
+size_t Print::write(const uint8_t * buffer, size_t size) {
+    size_t n = 0;
+    while (size--) {
+        n += write(*buffer++);
+    }
+    return n;
+}
+
+size_t Print::write(const char * str) {
+    if (str == nullptr) {
+        return 0;
+    }
+    return write(reinterpret_cast<const uint8_t *>(str), strlen(str));
+}
+
+size_t Print::print(const __FlashStringHelper * str) {
+    return write(reinterpret_cast<const char *>(str));
+}
+
+size_t Print::print(const char * str) {
+    return write(str);
+}
+
+size_t Print::print(char c) {
+    return write(static_cast<uint8_t>(c));
+}
+
+size_t Print::print(unsigned char n, int base) {
+    return print(static_cast<unsigned long>(n), base);
+}
+
+size_t Print::print(int n, int base) {
+    return print(static_cast<long>(n), base);
+}
+
+size_t Print::print(unsigned int n, int base) {
+    return print(static_cast<unsigned long>(n), base);
+}
+
+size_t Print::print(long n, int base) {
+    if (base == 0) {
+        return write(static_cast<uint8_t>(n));
+    }
+    if (base == DEC && n < 0) {
+        size_t t = print('-');
+        return t + PrintNumber(static_cast<unsigned long>(-n), DEC);
+    }
+    return PrintNumber(static_cast<unsigned long>(n), static_cast<uint8_t>(base));
+}
+
+size_t Print::print(unsigned long n, int base) {
+    if (base == 0) {
+        return write(static_cast<uint8_t>(n));
+    }
+    return PrintNumber(n, static_cast<uint8_t>(base));
+}
+
+size_t Print::print(double n, int digits) {
+    return PrintFloat(n, static_cast<uint8_t>(digits));
+}
+
+size_t Print::println(void) {
+    return write("\r\n");
+}
+
+size_t Print::println(const __FlashStringHelper * str) {
+    return print(str) + println();
+}
+
+size_t Print::println(const char * str) {
+    return print(str) + println();
+}
+
+size_t Print::println(char c) {
+    return print(c) + println();
+}
+
+size_t Print::println(unsigned char n, int base) {
+    return print(n, base) + println();
+}
+
+size_t Print::println(int n, int base) {
+    return print(n, base) + println();
+}
+
+size_t Print::println(unsigned int n, int base) {
+    return print(n, base) + println();
+}
+
+size_t Print::println(long n, int base) {
+    return print(n, base) + println();
+}
+
+size_t Print::println(unsigned long n, int base) {
+    return print(n, base) + println();
+}
+
+size_t Print::println(double n, int digits) {
+    return print(n, digits) + println();
+}
+
+size_t Print::PrintNumber(unsigned long n, uint8_t base) {
+    char   buffer[8 * sizeof(long) + 1];
+    char * str = &buffer[sizeof(buffer) - 1];
+    *str       = '\0';
+
+    if (base < 2) {
+        base = 10;
+    }
+
+    do {
+        char c = static_cast<char>(n % base);
+        n /= base;
+        *--str = static_cast<char>(c < 10 ? c + '0' : c + 'A' - 10);
+    } while (n);
+
+    return write(str);
+}
+
+// Same rounding and limits as the Arduino core, so logs read identically.
+size_t Print::PrintFloat(double number, uint8_t digits) {
+    if (isnan(number)) {
+        return print("nan");
+    }
+    if (isinf(number)) {
+        return print("inf");
+    }
+    if (number > 4294967040.0 || number < -4294967040.0) {
+        return print("ovf");
+    }
+
+    size_t n = 0;
+    if (number < 0.0) {
+        n += print('-');
+        number = -number;
+    }
+
+    double rounding = 0.5;
+    for (uint8_t i = 0; i < digits; ++i) {
+        rounding /= 10.0;
+    }
+    number += rounding;
+
+    unsigned long int_part  = static_cast<unsigned long>(number);
+    double        remainder = number - static_cast<double>(int_part);
+    n += print(int_part);
+
+    if (digits > 0) {
+        n += print('.');
+    }
+
+    while (digits-- > 0) {
+        remainder *= 10.0;
+        unsigned int to_print = static_cast<unsigned int>(remainder);
+        n += print(to_print);
+        remainder -= to_print;
+    }
+
+    return n;
+}
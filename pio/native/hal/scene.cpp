@@ -0,0 +1,166 @@
+#include "scene.h"
+
+#include <math.h>
+
+namespace Sim {
+
+namespace {
+
+const float kLsbPerG         = 16384.f;
+const float kLsbPerDegPerSec = 131.f;
+const float kDegToRad        = static_cast<float>(M_PI) / 180.f;
+
+// Deterministic noise in [-amplitude, amplitude] for a given time and channel.
+int16_t NoiseAt(uint64_t micros, uint32_t channel, int16_t amplitude) {
+    if (amplitude == 0) {
+        return 0;
+    }
+    uint32_t x = static_cast<uint32_t>(micros / 1000) * 2654435761u ^ (channel * 40503u);
+    x ^= x >> 13;
+    x *= 0x5bd1e995u;
+    x ^= x >> 15;
+    return static_cast<int16_t>(static_cast<int32_t>(x % (2u * amplitude + 1)) - amplitude);
+}
+
+int16_t ToLsb(float value) {
+    if (value > 32767.f) {
+        return 32767;
+    }
+    if (value < -32768.f) {
+        return -32768;
+    }
+    return static_cast<int16_t>(lroundf(value));
+}
+
+}  // namespace
+
+Scene::Scene(void) : duration_ms_(0), accel_noise_lsb_(0), gyro_noise_lsb_(0) {}
+
+float Scene::LastTilt(void) const {
+    return segments_.empty() ? 0.f : segments_.back().tilt_to_deg;
+}
+
+float Scene::LastRoll(void) const {
+    return segments_.empty() ? 0.f : segments_.back().roll_to_deg;
+}
+
+Scene & Scene::Hold(uint32_t duration_ms, float tilt_deg, float roll_deg) {
+    segments_.push_back({duration_ms, tilt_deg, tilt_deg, roll_deg, roll_deg, Easing::kLinear, 0.f, 0.f});
+    duration_ms_ += duration_ms;
+    return *this;
+}
+
+Scene & Scene::Move(uint32_t duration_ms, float tilt_to_deg, float roll_to_deg, Easing easing) {
+    segments_.push_back({duration_ms, LastTilt(), tilt_to_deg, LastRoll(), roll_to_deg, easing, 0.f, 0.f});
+    duration_ms_ += duration_ms;
+    return *this;
+}
+
+Scene & Scene::Balance(uint32_t duration_ms, float wobble_deg, float wobble_hz) {
+    float tilt = LastTilt();
+    float roll = LastRoll();
+    segments_.push_back({duration_ms, tilt, tilt, roll, roll, Easing::kLinear, wobble_deg, wobble_hz});
+    duration_ms_ += duration_ms;
+    return *this;
+}
+
+Scene & Scene::Noise(int16_t accel_lsb, int16_t gyro_lsb) {
+    accel_noise_lsb_ = accel_lsb;
+    gyro_noise_lsb_  = gyro_lsb;
+    return *this;
+}
+
+Accel Scene::Gravity(float tilt_deg, float roll_deg) {
+    float tilt = tilt_deg * kDegToRad;
+    float roll = roll_deg * kDegToRad;
+
+    Accel accel = {
+        ToLsb(kLsbPerG * sinf(roll) * cosf(tilt)),
+        ToLsb(-kLsbPerG * cosf(roll) * cosf(tilt)),
+        ToLsb(-kLsbPerG * sinf(tilt)),
+    };
+    return accel;
+}
+
+Motion Scene::operator()(uint64_t micros) const {
+    Motion motion = {{0, 0, 0}, {0, 0, 0}};
+    if (segments_.empty() || duration_ms_ == 0) {
+        motion.accel = Gravity(0.f, 0.f);
+        return motion;
+    }
+
+    float t_ms = static_cast<float>(micros % (1000ULL * duration_ms_)) / 1000.f;
+
+    const Segment * segment = &segments_.back();
+    for (const Segment & candidate : segments_) {
+        if (t_ms < candidate.duration_ms) {
+            segment = &candidate;
+            break;
+        }
+        t_ms -= candidate.duration_ms;
+    }
+
+    float duration_s = segment->duration_ms / 1000.f;
+    float progress   = segment->duration_ms > 0 ? t_ms / segment->duration_ms : 1.f;
+    float eased      = progress;
+    float eased_rate = 1.f;
+    if (segment->easing == Easing::kFall) {
+        eased      = progress * progress;
+        eased_rate = 2.f * progress;
+    }
+
+    float t_s         = t_ms / 1000.f;
+    float wobble      = segment->wobble_deg * sinf(2.f * static_cast<float>(M_PI) * segment->wobble_hz * t_s);
+    float wobble_rate = segment->wobble_deg * 2.f * static_cast<float>(M_PI) * segment->wobble_hz *
+                        cosf(2.f * static_cast<float>(M_PI) * segment->wobble_hz * t_s);
+
+    float tilt = segment->tilt_from_deg + (segment->tilt_to_deg - segment->tilt_from_deg) * eased + wobble;
+    float roll = segment->roll_from_deg + (segment->roll_to_deg - segment->roll_from_deg) * eased;
+
+    float tilt_rate = wobble_rate;
+    float roll_rate = 0.f;
+    if (duration_s > 0.f) {
+        tilt_rate += (segment->tilt_to_deg - segment->tilt_from_deg) * eased_rate / duration_s;
+        roll_rate += (segment->roll_to_deg - segment->roll_from_deg) * eased_rate / duration_s;
+    }
+
+    motion.accel = Gravity(tilt, roll);
+    motion.accel.x += NoiseAt(micros, 0, accel_noise_lsb_);
+    motion.accel.y += NoiseAt(micros, 1, accel_noise_lsb_);
+    motion.accel.z += NoiseAt(micros, 2, accel_noise_lsb_);
+
+    // The body rates that turn `Gravity(tilt, roll)` as the sensor sees it,
+    // dg/dt = g × ω: tilting turns about the horizontal axis across the roll.
+    float roll_rad = roll * kDegToRad;
+    motion.gyro.x  = lroundf(-tilt_rate * cosf(roll_rad) * kLsbPerDegPerSec) + NoiseAt(micros, 3, gyro_noise_lsb_);
+    motion.gyro.y  = lroundf(-tilt_rate * sinf(roll_rad) * kLsbPerDegPerSec) + NoiseAt(micros, 4, gyro_noise_lsb_);
+    motion.gyro.z  = lroundf(-roll_rate * kLsbPerDegPerSec) + NoiseAt(micros, 5, gyro_noise_lsb_);
+
+    return motion;
+}
+
+Scene Scene::Session(void) {
+    Scene scene;
+    scene.Noise(150, 20)
+        // Battery check and a short idle.
+        .Hold(8000, 90.f)
+        // Pick up, balance, drop.
+        .Move(600, 0.f)
+        .Balance(12000, 4.f, 0.7f)
+        .Move(450, 90.f, 0.f, Easing::kFall)
+        .Hold(3000, 90.f)
+        // A longer round that beats the record.
+        .Move(600, 0.f)
+        .Balance(20000, 6.f, 0.9f)
+        .Move(400, -90.f, 0.f, Easing::kFall)
+        .Hold(2000, -90.f)
+        // Spirit level on the long edge.
+        .Move(800, 0.f, 90.f)
+        .Hold(6000, 0.f, 90.f)
+        .Move(800, 90.f, 0.f)
+        // Left on the table until it sleeps.
+        .Hold(90000, 90.f);
+    return scene;
+}
+
+}  // namespace Sim
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "sim.h"
+
+namespace Sim {
+
+// Scripted stick motion, for use as a `MotionSource`.
+//
+// The pose is given as two angles applied to the upright stick, whose
+// gravity vector reads (0, -1g, 0) on the sensor:
+//   tilt: rotation about the sensor X axis, 90° lies flat buttons up;
+//   roll: rotation about the sensor Z axis, 90° lies on the long edge.
+// Each segment moves from one pose to the next, optionally with a balancing
+// wobble and sensor noise, and the script repeats once it runs out.
+class Scene {
+  public:
+    enum class Easing {
+        kLinear,
+        // Accelerates like a toppling stick.
+        kFall,
+    };
+
+    struct Segment {
+        uint32_t duration_ms;
+        float    tilt_from_deg;
+        float    tilt_to_deg;
+        float    roll_from_deg;
+        float    roll_to_deg;
+        Easing   easing;
+        // Balancing wobble around the pose.
+        float wobble_deg;
+        float wobble_hz;
+    };
+
+    Scene(void);
+
+    Scene & Hold(uint32_t duration_ms, float tilt_deg, float roll_deg = 0.f);
+    Scene & Move(uint32_t duration_ms, float tilt_to_deg, float roll_to_deg = 0.f, Easing easing = Easing::kLinear);
+    Scene & Balance(uint32_t duration_ms, float wobble_deg, float wobble_hz);
+
+    // Peak sensor noise in LSB added to each axis.
+    Scene & Noise(int16_t accel_lsb, int16_t gyro_lsb);
+
+    uint32_t GetDurationMs(void) const { return duration_ms_; }
+
+    Motion operator()(uint64_t micros) const;
+
+    // A few rounds of play, idle, spirit level and sleep.
+    static Scene Session(void);
+
+    // Pose of a stick tilted `tilt_deg` from upright, as a `Hold` would report it.
+    static Accel Gravity(float tilt_deg, float roll_deg);
+
+  private:
+    std::vector<Segment> segments_;
+    uint32_t             duration_ms_;
+    int16_t              accel_noise_lsb_;
+    int16_t              gyro_noise_lsb_;
+
+    float LastTilt(void) const;
+    float LastRoll(void) const;
+};
+
+}  // namespace Sim
@@ -0,0 +1,228 @@
+#include "sim.h"
+
+#include <algorithm>
+
+#include <Arduino.h>
+#include <avr/sleep.h>
+
+#include "mpuModel.h"
+#include "simModels.h"
+
+namespace Sim {
+
+namespace {
+
+const uint8_t kNumInterrupts = 2;
+
+// Timer0, behind `millis()`, overflows every 64 × 256 cycles: 1365 us at 12 MHz.
+const uint64_t kTimer0OverflowUs = 64ULL * 256 * 1000000 / F_CPU;
+
+// Granularity of waking from idle on a pin interrupt.
+const uint32_t kIdleStepUs = 16;
+
+struct ExternalInterrupt {
+    void (*handler)(void);
+    int  mode;
+    bool level;
+};
+
+uint64_t          now_us      = 0;
+uint64_t          deadline_us = 0;
+bool              ticking     = false;
+MotionSource      motion_source;
+FrameSink         frame_sink;
+int               vcc_mv = 3300;
+Stats             stats;
+ExternalInterrupt interrupts[kNumInterrupts];
+
+// Number of pin interrupt handlers run, used to tell when sleep ends.
+uint32_t handlers_run       = 0;
+uint32_t level_handlers_run = 0;
+
+// Sits flat on the table, buttons up.
+Motion RestingMotion(uint64_t) {
+    Motion motion = {{0, 0, -16384}, {0, 0, 0}};
+    return motion;
+}
+
+int PinToInterrupt(uint8_t pin) {
+    return digitalPinToInterrupt(pin);
+}
+
+void Dispatch(ExternalInterrupt & interrupt, bool previous) {
+    if (interrupt.handler == nullptr || !(SREG & _BV(SREG_I))) {
+        return;
+    }
+
+    bool fire = false;
+    switch (interrupt.mode) {
+        case LOW:
+            fire = !interrupt.level;
+            break;
+        case CHANGE:
+            fire = previous != interrupt.level;
+            break;
+        case FALLING:
+            fire = previous && !interrupt.level;
+            break;
+        case RISING:
+            fire = !previous && interrupt.level;
+            break;
+    }
+
+    if (fire) {
+        ++handlers_run;
+        if (interrupt.mode == LOW) {
+            ++level_handlers_run;
+        }
+        interrupt.handler();
+    }
+}
+
+}  // namespace
+
+uint64_t Now(void) {
+    return now_us;
+}
+
+void Advance(uint32_t us) {
+    now_us += us;
+
+    // Keep the MPU interrupt line and the ADC current so interrupts fire on time.
+    if (!ticking) {
+        ticking = true;
+        GetMpuModel().Tick();
+        TickAdc();
+        ticking = false;
+    }
+}
+
+void Reset(void) {
+    now_us      = 0;
+    deadline_us = 0;
+    stats       = Stats();
+    SREG.Set(_BV(SREG_I));
+
+    for (uint8_t i = 0; i < kNumInterrupts; ++i) {
+        interrupts[i].handler = nullptr;
+        interrupts[i].mode    = LOW;
+        interrupts[i].level   = true;
+    }
+
+    ResetAdc();
+    ResetEeprom();
+    GetMpuModel().Reset();
+    AttachI2cDevice(MpuModel::kAddress, &GetMpuModel());
+}
+
+void SetDeadline(uint64_t micros) {
+    deadline_us = micros;
+}
+
+bool DeadlinePassed(void) {
+    return deadline_us != 0 && now_us >= deadline_us;
+}
+
+uint64_t GetDeadline(void) {
+    return deadline_us;
+}
+
+void SetMotionSource(MotionSource source) {
+    motion_source = source;
+}
+
+void SetFrameSink(FrameSink sink) {
+    frame_sink = sink;
+}
+
+FrameSink & GetFrameSink(void) {
+    return frame_sink;
+}
+
+Motion GetMotion(uint64_t micros) {
+    return motion_source ? motion_source(micros) : RestingMotion(micros);
+}
+
+void SetVccMillivolts(int millivolts) {
+    vcc_mv = millivolts;
+}
+
+int GetVccMillivolts(void) {
+    return vcc_mv;
+}
+
+Stats & MutableStats(void) {
+    return stats;
+}
+
+const Stats & GetStats(void) {
+    return stats;
+}
+
+void Sleep(uint8_t mode) {
+    uint64_t start_us = now_us;
+
+    if (mode == SLEEP_MODE_IDLE) {
+        // Timer0 keeps running in idle mode, so its overflow wakes the CPU if
+        // no pin interrupt does first.
+        uint64_t overflow_us = (now_us / kTimer0OverflowUs + 1) * kTimer0OverflowUs;
+        uint32_t handlers    = handlers_run;
+        while (now_us < overflow_us && handlers == handlers_run && !DeadlinePassed()) {
+            Advance(static_cast<uint32_t>(std::min<uint64_t>(kIdleStepUs, overflow_us - now_us)));
+        }
+
+        ++stats.idles;
+        stats.idle_us += now_us - start_us;
+        return;
+    }
+
+    ++stats.sleeps;
+    while (!DeadlinePassed()) {
+        uint32_t handlers       = handlers_run;
+        uint32_t level_handlers = level_handlers_run;
+
+        Advance(1000);
+
+        // Only a low level on INT0/INT1 wakes the CPU from the deeper modes,
+        // edges are not detected without the I/O clock.
+        if (level_handlers != level_handlers_run || (mode == SLEEP_MODE_ADC && handlers != handlers_run)) {
+            break;
+        }
+    }
+
+    stats.sleep_us += now_us - start_us;
+}
+
+void SetInterruptPin(uint8_t pin, bool level) {
+    int interrupt_num = PinToInterrupt(pin);
+    if (interrupt_num < 0) {
+        return;
+    }
+
+    ExternalInterrupt & interrupt = interrupts[interrupt_num];
+    bool                previous  = interrupt.level;
+    interrupt.level               = level;
+    Dispatch(interrupt, previous);
+}
+
+bool GetInterruptPin(uint8_t pin) {
+    int interrupt_num = PinToInterrupt(pin);
+    return interrupt_num < 0 ? true : interrupts[interrupt_num].level;
+}
+
+void AttachInterrupt(uint8_t interrupt_num, void (*handler)(void), int mode) {
+    if (interrupt_num >= kNumInterrupts) {
+        return;
+    }
+    interrupts[interrupt_num].handler = handler;
+    interrupts[interrupt_num].mode    = mode;
+}
+
+void DetachInterrupt(uint8_t interrupt_num) {
+    if (interrupt_num >= kNumInterrupts) {
+        return;
+    }
+    interrupts[interrupt_num].handler = nullptr;
+}
+
+}  // namespace Sim
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <functional>
+
+// Control surface of the host simulation.
+//
+// The HAL replaces the Arduino core, Wire, the ADC registers and the
+// FastLED output stage with models that run against a simulated clock.
+// Nothing advances the clock except the models themselves (bus transfers,
+// LED frames, Serial output, `delay()`, sleep and reading the clock), so the
+// simulated time a `loop()` takes is what the same code would block for on
+// the device.
+namespace Sim {
+
+// Acceleration applied to the MPU6050, in raw ±2g LSB (16384 per g).
+struct Accel {
+    int16_t x;
+    int16_t y;
+    int16_t z;
+};
+
+// Rotation rate applied to the MPU6050, in raw ±250°/s LSB (131 per °/s) but
+// unclamped, so the wider ranges see rates past 250°/s.
+struct Gyro {
+    int32_t x;
+    int32_t y;
+    int32_t z;
+};
+
+struct Motion {
+    Accel accel;
+    Gyro  gyro;
+};
+
+// Supplies the motion of the stick at a given simulated time.
+typedef std::function<Motion(uint64_t micros)> MotionSource;
+
+// Receives every frame pushed by `FastLED.show()`, as packed RGB triplets.
+typedef std::function<void(uint64_t micros, const uint8_t * rgb, int count, uint8_t brightness)> FrameSink;
+
+// Counters accumulated by the models since the last `Reset()`.
+struct Stats {
+    uint32_t frames_shown;
+    uint32_t led_bytes_shown;
+    uint32_t i2c_transactions;
+    uint32_t i2c_bytes;
+    uint32_t serial_bytes;
+    uint32_t adc_conversions;
+    uint32_t eeprom_writes;
+    uint64_t led_us;
+    // Highest current of a shown strip, by FastLED's power_mgt estimate.
+    uint32_t led_peak_ma;
+    uint64_t i2c_us;
+    uint64_t serial_us;
+    uint64_t delay_us;
+    uint64_t sleep_us;
+    uint32_t sleeps;
+    // `SLEEP_MODE_IDLE`, counted apart from the deeper sleeps above.
+    uint64_t idle_us;
+    uint32_t idles;
+    // The MPU's supply current integrated over time, by its power mode.
+    uint64_t mpu_ua_us;
+    // Times the MPU FIFO filled up, or was reset with no room left for a
+    // sample, as the firmware does before it overflows.
+    uint32_t fifo_overflows;
+};
+
+// Clock.
+uint64_t Now(void);
+void     Advance(uint32_t us);
+
+// Reset the clock, the models and the counters.
+void Reset(void);
+
+// Stop running once the clock passes `micros`; 0 runs forever.
+void     SetDeadline(uint64_t micros);
+bool     DeadlinePassed(void);
+uint64_t GetDeadline(void);
+
+void SetMotionSource(MotionSource source);
+void SetFrameSink(FrameSink sink);
+
+// Motion of the stick at a given simulated time.
+Motion GetMotion(uint64_t micros);
+
+// Supply voltage reported to the ADC, in millivolts.
+void SetVccMillivolts(int millivolts);
+int  GetVccMillivolts(void);
+
+// EEPROM contents, erased by `Reset()`, e.g. to keep them across runs.
+uint8_t * GetEeprom(void);
+uint16_t  GetEepromSize(void);
+
+// Echo Serial output to stdout.
+void SetSerialEcho(bool echo);
+
+// Bytes for Serial to read, as if the host sent them at boot. `bytes` must
+// outlive the run.
+void SetSerialInput(const char * bytes);
+
+const Stats & GetStats(void);
+
+// Called by the sleep model: advance the clock until an interrupt that wakes
+// the CPU from `mode` fires, or the deadline passes.
+void Sleep(uint8_t mode);
+
+// External interrupt line driven by the MPU6050 INT pin.
+void SetInterruptPin(uint8_t pin, bool level);
+bool GetInterruptPin(uint8_t pin);
+
+}  // namespace Sim
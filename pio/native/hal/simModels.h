@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "sim.h"
+
+// Hooks shared between the HAL models; not part of the simulation API.
+namespace Sim {
+
+Stats &     MutableStats(void);
+FrameSink & GetFrameSink(void);
+
+void AttachInterrupt(uint8_t interrupt_num, void (*handler)(void), int mode);
+void DetachInterrupt(uint8_t interrupt_num);
+
+// Power-on state of the ADC, and completion of a conversion in flight.
+void ResetAdc(void);
+void TickAdc(void);
+
+void ResetEeprom(void);
+
+}  // namespace Sim
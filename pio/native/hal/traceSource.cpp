@@ -0,0 +1,162 @@
+#include "traceSource.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+
+#include "sensorTrace.h"
+
+namespace Sim {
+
+namespace {
+
+uint16_t ReadUint16(const uint8_t * bytes) {
+    return static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+}
+
+uint32_t ReadUint32(const uint8_t * bytes) {
+    return static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8) |
+           (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+// Returns false if the varint runs past `end`.
+bool ReadVarint(const uint8_t ** bytes, const uint8_t * end, int16_t * value) {
+    uint16_t zigzag = 0;
+    for (uint8_t shift = 0; *bytes < end; shift += 7) {
+        uint8_t byte = *(*bytes)++;
+        zigzag |= static_cast<uint16_t>((byte & 0x7F) << shift);
+        if (!(byte & 0x80)) {
+            *value = static_cast<int16_t>((zigzag >> 1) ^ -(zigzag & 1));
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+TraceSource::TraceSource(void) : sample_rate_hz_(MPU_SAMPLE_RATE_HZ), corrupt_records_(0) {}
+
+bool TraceSource::Load(const char * path) {
+    FILE * file = fopen(path, "rb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    std::vector<uint8_t> data;
+    uint8_t              buffer[4096];
+    size_t               count;
+    while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.insert(data.end(), buffer, buffer + count);
+    }
+    fclose(file);
+
+    Parse(data);
+    return !samples_.empty();
+}
+
+void TraceSource::Parse(const std::vector<uint8_t> & data) {
+    samples_.clear();
+    corrupt_records_ = 0;
+
+    // `micros()` wraps every 71 minutes.
+    uint64_t clock_high = 0;
+
+    size_t i = 0;
+    while (i + 4 <= data.size()) {
+        if (data[i] != SensorTracing::kSync) {
+            ++i;
+            continue;
+        }
+
+        uint8_t type = data[i + 1];
+        uint8_t size = data[i + 2];
+        // The trace may come from a build with a larger burst than this one's
+        // `SensorTracing::kMaxPayloadSize`, the checksum vets the length.
+        if ((type != SensorTracing::kHeaderType && type != SensorTracing::kSamplesType) ||
+            i + 4 + size > data.size()) {
+            ++i;
+            continue;
+        }
+
+        const uint8_t * payload  = &data[i + 3];
+        uint8_t         checksum = type ^ size;
+        for (uint8_t j = 0; j < size; ++j) {
+            checksum ^= payload[j];
+        }
+        if (checksum != payload[size]) {
+            ++corrupt_records_;
+            ++i;
+            continue;
+        }
+
+        if (type == SensorTracing::kHeaderType && size >= 2) {
+            sample_rate_hz_ = std::max<uint16_t>(1, ReadUint16(payload));
+        } else if (type == SensorTracing::kSamplesType) {
+            ParseSamples(payload, size, &clock_high);
+        }
+        i += 4 + size;
+    }
+}
+
+void TraceSource::ParseSamples(const uint8_t * payload, uint8_t size, uint64_t * clock_high) {
+    if (size < 11) {
+        ++corrupt_records_;
+        return;
+    }
+
+    uint64_t last_us = *clock_high | ReadUint32(payload);
+    if (!samples_.empty() && last_us + 0x80000000ULL < samples_.back().micros) {
+        *clock_high += 0x100000000ULL;
+        last_us += 0x100000000ULL;
+    }
+
+    uint8_t count = payload[4];
+
+    std::vector<Accel> accels(1);
+    accels[0].x = static_cast<int16_t>(ReadUint16(payload + 5));
+    accels[0].y = static_cast<int16_t>(ReadUint16(payload + 7));
+    accels[0].z = static_cast<int16_t>(ReadUint16(payload + 9));
+
+    const uint8_t * bytes = payload + 11;
+    const uint8_t * end   = payload + size;
+    while (accels.size() < count) {
+        int16_t dx, dy, dz;
+        if (!ReadVarint(&bytes, end, &dx) || !ReadVarint(&bytes, end, &dy) || !ReadVarint(&bytes, end, &dz)) {
+            ++corrupt_records_;
+            return;
+        }
+        Accel accel = accels.back();
+        accel.x     = static_cast<int16_t>(accel.x + dx);
+        accel.y     = static_cast<int16_t>(accel.y + dy);
+        accel.z     = static_cast<int16_t>(accel.z + dz);
+        accels.push_back(accel);
+    }
+
+    uint64_t period_us = 1000000ULL / sample_rate_hz_;
+    for (size_t j = 0; j < accels.size(); ++j) {
+        uint64_t age_us = period_us * (accels.size() - 1 - j);
+        uint64_t micros = last_us > age_us ? last_us - age_us : 0;
+        if (!samples_.empty() && micros <= samples_.back().micros) {
+            // The device's estimate overlaps the previous record, keep the
+            // timeline ordered.
+            micros = samples_.back().micros + 1;
+        }
+        samples_.push_back({micros, accels[j]});
+    }
+}
+
+Motion TraceSource::operator()(uint64_t micros) const {
+    Motion motion = {};
+    if (samples_.empty()) {
+        return motion;
+    }
+
+    // Latest sample at or before `micros`, or the first one before the trace starts.
+    auto next = std::upper_bound(
+        samples_.begin(), samples_.end(), micros, [](uint64_t t, const Sample & sample) { return t < sample.micros; });
+    motion.accel = (next == samples_.begin() ? next : next - 1)->accel;
+    return motion;
+}
+
+}  // namespace Sim
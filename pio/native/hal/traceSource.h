@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "sim.h"
+
+namespace Sim {
+
+// Sensor trace recorded by the firmware with `SENSOR_TRACE`, for use as a
+// `MotionSource`.
+//
+// The trace is read from the raw bytes of a capture: anything between the
+// records, such as text logs, is skipped. Sample times are on the device's
+// clock, which starts at reset like the simulated one. The motion holds each sample
+// until the next, and the last one after the trace ends.
+class TraceSource {
+  public:
+    struct Sample {
+        uint64_t micros;
+        Accel    accel;
+    };
+
+    TraceSource(void);
+
+    // Returns false if the file can't be read or holds no samples.
+    bool Load(const char * path);
+
+    void Parse(const std::vector<uint8_t> & data);
+
+    const std::vector<Sample> & GetSamples(void) const { return samples_; }
+
+    uint64_t GetEndMicros(void) const { return samples_.empty() ? 0 : samples_.back().micros; }
+
+    // Records dropped for a bad checksum or length.
+    uint32_t GetCorruptRecords(void) const { return corrupt_records_; }
+
+    Motion operator()(uint64_t micros) const;
+
+  private:
+    std::vector<Sample> samples_;
+    uint16_t            sample_rate_hz_;
+    uint32_t            corrupt_records_;
+
+    void ParseSamples(const uint8_t * payload, uint8_t size, uint64_t * clock_high);
+};
+
+}  // namespace Sim
@@ -0,0 +1,7 @@
+// Vendored FastLED source, built against the host HAL.
+#include <FastLED.h>
+
+// colorpalettes.cpp opens with colorpalettes.h's include guard, which would
+// skip it once the header is in. The AVR build compiles it first.
+#undef __INC_COLORPALETTES_H
+#include <colorpalettes.cpp>
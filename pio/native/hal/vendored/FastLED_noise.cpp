@@ -0,0 +1,4 @@
+// Vendored FastLED source, built against the host HAL.
+#include <FastLED.h>
+
+#include <noise.cpp>
@@ -0,0 +1,2 @@
+// Vendored I2Cdevlib source, built against the host HAL.
+#include <I2Cdev.cpp>
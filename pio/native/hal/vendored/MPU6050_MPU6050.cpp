@@ -0,0 +1,10 @@
+// Vendored I2Cdevlib source, built against the host HAL.
+#include "configuration.h"
+
+// The same `MPU6050` layout as `mpu.h` declares.
+#if POSITION_DMP
+#    include "I2Cdev.h"
+#    include "helper_3dmath.h"
+#    define MPU6050_INCLUDE_DMP_MOTIONAPPS20
+#endif
+#include <MPU6050.cpp>
@@ -0,0 +1,2 @@
+// Vendored RunningMedian source, built against the host HAL.
+#include <RunningMedian.cpp>
@@ -0,0 +1,118 @@
+#include "Wire.h"
+
+#include "sim.h"
+#include "simModels.h"
+
+TwoWire Wire;
+
+namespace {
+
+const uint8_t kMaxDevices = 4;
+
+struct Attachment {
+    uint8_t          address;
+    Sim::I2cDevice * device;
+};
+
+Attachment attachments[kMaxDevices];
+uint8_t    num_attachments = 0;
+
+Sim::I2cDevice * FindDevice(uint8_t address) {
+    for (uint8_t i = 0; i < num_attachments; ++i) {
+        if (attachments[i].address == address) {
+            return attachments[i].device;
+        }
+    }
+    return nullptr;
+}
+
+}  // namespace
+
+namespace Sim {
+
+void AttachI2cDevice(uint8_t address, I2cDevice * device) {
+    for (uint8_t i = 0; i < num_attachments; ++i) {
+        if (attachments[i].address == address) {
+            attachments[i].device = device;
+            return;
+        }
+    }
+    if (num_attachments < kMaxDevices) {
+        attachments[num_attachments++] = {address, device};
+    }
+}
+
+}  // namespace Sim
+
+void TwoWire::begin(void) {
+    frequency_ = 100000;
+}
+
+void TwoWire::setClock(uint32_t frequency) {
+    frequency_ = frequency;
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+    tx_address_ = address;
+    tx_length_  = 0;
+}
+
+size_t TwoWire::write(uint8_t data) {
+    if (tx_length_ >= BUFFER_LENGTH) {
+        return 0;
+    }
+    tx_buffer_[tx_length_++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t * data, size_t quantity) {
+    size_t written = 0;
+    while (written < quantity && write(data[written])) {
+        ++written;
+    }
+    return written;
+}
+
+uint8_t TwoWire::endTransmission(bool) {
+    // Address byte plus payload.
+    ChargeBus(static_cast<uint8_t>(1 + tx_length_));
+
+    Sim::I2cDevice * device = FindDevice(tx_address_);
+    if (device == nullptr) {
+        return 2;
+    }
+
+    device->Receive(tx_buffer_, tx_length_);
+    return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, bool) {
+    if (quantity > BUFFER_LENGTH) {
+        quantity = BUFFER_LENGTH;
+    }
+
+    ChargeBus(static_cast<uint8_t>(1 + quantity));
+
+    rx_index_  = 0;
+    rx_length_ = 0;
+
+    Sim::I2cDevice * device = FindDevice(address);
+    if (device != nullptr) {
+        rx_length_ = device->Transmit(rx_buffer_, quantity);
+    }
+
+    return rx_length_;
+}
+
+// Each byte is 8 data bits plus ACK; start and stop conditions add about one more.
+void TwoWire::ChargeBus(uint8_t bytes) {
+    uint32_t bits = 9UL * bytes + 2;
+    uint32_t us   = static_cast<uint32_t>((bits * 1000000ULL + frequency_ - 1) / frequency_);
+
+    Sim::Stats & stats = Sim::MutableStats();
+    ++stats.i2c_transactions;
+    stats.i2c_bytes += bytes;
+    stats.i2c_us += us;
+
+    Sim::Advance(us);
+}
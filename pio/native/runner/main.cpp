@@ -0,0 +1,306 @@
+// Runs the firmware's `setup()`/`loop()` against the simulated HAL and reports
+// how long each `loop()` blocks in simulated time, where that time goes, and
+// the state timeline.
+//
+//   .pioenvs/native/program [--seconds N] [--serial] [--send BYTES] [--states] [--frames] [--pixels]
+//                           [--replay TRACE] [--eeprom FILE] [--vcc MV] [--drain MV_PER_HOUR]
+//
+// The stick follows the scripted play session, or with `--replay` a sensor
+// trace recorded with `SENSOR_TRACE` (see `tools/sensor_trace.py`), until the
+// trace ends unless `--seconds` is given. `--pixels` adds the LED colors to
+// each `--frames` line, so two runs can be diffed frame by frame. `--send`
+// gives Serial BYTES to read, e.g. `d` for the discharge log.
+//
+// `--eeprom` loads the EEPROM from FILE, if it exists, and saves it back at
+// the end, so the discharge log carries over between runs. `--vcc` sets Vcc,
+// 3300 mV by default, and `--drain` lowers it steadily from there, or from
+// 3350 mV.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <map>
+
+#include <Arduino.h>
+
+#include "behavior.h"
+#include "dutyCycle.h"
+#include "scene.h"
+#include "scheduler.h"
+#include "sim.h"
+#include "stecchino.h"
+#include "traceSource.h"
+
+extern Behavior *  behavior;
+extern DutyCycle * duty_cycle;
+extern Scheduler * scheduler;
+
+void setup(void);
+void loop(void);
+
+namespace {
+
+struct Options {
+    // 0 for the default: 600, or the length of the replayed trace.
+    uint32_t     seconds = 0;
+    bool         serial  = false;
+    const char * send    = "";
+    bool         states  = false;
+    bool         frames  = false;
+    bool         pixels  = false;
+    const char * replay  = nullptr;
+    const char * eeprom  = nullptr;
+    int          vcc     = 0;
+    double       drain   = 0;
+};
+
+const char * StateName(Stecchino::State state) {
+    switch (state) {
+        case Stecchino::State::kCheckBattery:
+            return "CheckBattery";
+        case Stecchino::State::kFakeSleep:
+            return "FakeSleep";
+        case Stecchino::State::kGameOverTransition:
+            return "GameOverTransition";
+        case Stecchino::State::kIdle:
+            return "Idle";
+        case Stecchino::State::kPlay:
+            return "Play";
+        case Stecchino::State::kSleepTransition:
+            return "SleepTransition";
+        case Stecchino::State::kSpiritLevel:
+            return "SpiritLevel";
+        case Stecchino::State::kStartPlayTransition:
+            return "StartPlayTransition";
+        default:
+            return "Unknown";
+    }
+}
+
+bool ParseOptions(int argc, char ** argv, Options * options) {
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            options->seconds = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--serial") == 0) {
+            options->serial = true;
+        } else if (strcmp(argv[i], "--send") == 0 && i + 1 < argc) {
+            options->send = argv[++i];
+        } else if (strcmp(argv[i], "--states") == 0) {
+            options->states = true;
+        } else if (strcmp(argv[i], "--frames") == 0) {
+            options->frames = true;
+        } else if (strcmp(argv[i], "--pixels") == 0) {
+            options->frames = true;
+            options->pixels = true;
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            options->replay = argv[++i];
+        } else if (strcmp(argv[i], "--eeprom") == 0 && i + 1 < argc) {
+            options->eeprom = argv[++i];
+        } else if (strcmp(argv[i], "--vcc") == 0 && i + 1 < argc) {
+            options->vcc = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--drain") == 0 && i + 1 < argc) {
+            options->drain = strtod(argv[++i], nullptr);
+        } else {
+            fprintf(stderr,
+                    "usage: %s [--seconds N] [--serial] [--send BYTES] [--states] [--frames] [--pixels] "
+                    "[--replay TRACE] [--eeprom FILE] [--vcc MV] [--drain MV_PER_HOUR]\n",
+                    argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Loop durations in us, with how many loops took that long.
+typedef std::map<uint64_t, uint64_t> Histogram;
+
+uint64_t Percentile(const Histogram & histogram, uint64_t count, double percentile) {
+    uint64_t rank = static_cast<uint64_t>(percentile * (count - 1));
+    for (const auto & bucket : histogram) {
+        if (rank < bucket.second) {
+            return bucket.first;
+        }
+        rank -= bucket.second;
+    }
+    return 0;
+}
+
+// In the order `setup()` adds them.
+const char * TaskName(uint8_t task) {
+    static const char * const kNames[] = {"Position", "LedStrip", "Report", "BatteryLevel", "Behavior"};
+    return task < sizeof(kNames) / sizeof(kNames[0]) ? kNames[task] : "?";
+}
+
+void LoadEeprom(const char * path) {
+    FILE * file = fopen(path, "rb");
+    if (file != nullptr) {
+        size_t size = fread(Sim::GetEeprom(), 1, Sim::GetEepromSize(), file);
+        (void)size;
+        fclose(file);
+    }
+}
+
+void SaveEeprom(const char * path) {
+    FILE * file = fopen(path, "wb");
+    if (file == nullptr) {
+        perror(path);
+        return;
+    }
+    fwrite(Sim::GetEeprom(), 1, Sim::GetEepromSize(), file);
+    fclose(file);
+}
+
+double Share(uint64_t part_us, uint64_t total_us) {
+    return total_us == 0 ? 0. : 100. * part_us / total_us;
+}
+
+}  // namespace
+
+int main(int argc, char ** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, &options)) {
+        return 2;
+    }
+
+    Sim::Reset();
+    Sim::SetSerialEcho(options.serial);
+    Sim::SetSerialInput(options.send);
+
+    uint64_t deadline_us = 1000000ULL * (options.seconds ? options.seconds : 600);
+    if (options.replay != nullptr) {
+        Sim::TraceSource trace;
+        if (!trace.Load(options.replay)) {
+            fprintf(stderr, "%s: no sensor trace records\n", options.replay);
+            return 1;
+        }
+        if (trace.GetCorruptRecords() != 0) {
+            fprintf(stderr, "%s: skipped %u corrupt records\n", options.replay, trace.GetCorruptRecords());
+        }
+        if (options.seconds == 0) {
+            deadline_us = trace.GetEndMicros();
+        }
+        Sim::SetMotionSource(trace);
+    } else {
+        Sim::SetMotionSource(Sim::Scene::Session());
+    }
+    Sim::SetDeadline(deadline_us);
+
+    if (options.frames) {
+        bool pixels = options.pixels;
+        Sim::SetFrameSink([pixels](uint64_t micros, const uint8_t * rgb, int count, uint8_t brightness) {
+            int lit = 0;
+            for (int i = 0; i < count; ++i) {
+                if (rgb[3 * i] || rgb[3 * i + 1] || rgb[3 * i + 2]) {
+                    ++lit;
+                }
+            }
+            printf("%10.3f frame lit=%d brightness=%d", micros / 1e6, lit, brightness);
+            if (pixels) {
+                printf(" rgb=");
+                for (int i = 0; i < 3 * count; ++i) {
+                    printf("%02x", rgb[i]);
+                }
+            }
+            printf("\n");
+        });
+    }
+
+    if (options.eeprom != nullptr) {
+        LoadEeprom(options.eeprom);
+    }
+    if (options.vcc == 0 && options.drain > 0) {
+        options.vcc = 3350;
+    }
+    if (options.vcc != 0) {
+        Sim::SetVccMillivolts(options.vcc);
+    }
+
+    auto wall_start = std::chrono::steady_clock::now();
+
+    setup();
+
+    Histogram        loop_us;
+    uint64_t         loops = 0;
+    Stecchino::State state = behavior->GetState();
+
+    while (!Sim::DeadlinePassed()) {
+        uint64_t start = Sim::Now();
+        loop();
+        ++loop_us[Sim::Now() - start];
+        ++loops;
+
+        if (options.drain > 0) {
+            Sim::SetVccMillivolts(static_cast<int>(options.vcc - options.drain * Sim::Now() / 3.6e9));
+        }
+
+        if (behavior->GetState() != state) {
+            state = behavior->GetState();
+            if (options.states) {
+                printf("%10.3f state %s\n", Sim::Now() / 1e6, StateName(state));
+            }
+        }
+    }
+
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+
+    const Sim::Stats & stats  = Sim::GetStats();
+    uint64_t           total  = Sim::Now();
+    uint64_t           max_us = loops ? loop_us.rbegin()->first : 0;
+    uint64_t           p50_us = loops ? Percentile(loop_us, loops, 0.50) : 0;
+    uint64_t           p99_us = loops ? Percentile(loop_us, loops, 0.99) : 0;
+
+    printf("simulated         : %.1f s in %.2f s wall (%.0fx)\n", total / 1e6, wall_s, total / 1e6 / wall_s);
+    printf("loops             : %llu (%.1f Hz)\n",
+           static_cast<unsigned long long>(loops),
+           loops / (total / 1e6));
+    printf("loop p50/p99/max  : %llu / %llu / %llu us\n",
+           static_cast<unsigned long long>(p50_us),
+           static_cast<unsigned long long>(p99_us),
+           static_cast<unsigned long long>(max_us));
+    printf("serial            : %u bytes, %.1f%% of time blocked\n", stats.serial_bytes, Share(stats.serial_us, total));
+    printf("i2c               : %u transactions, %u bytes, %.1f%% of time\n",
+           stats.i2c_transactions,
+           stats.i2c_bytes,
+           Share(stats.i2c_us, total));
+    printf("leds              : %u frames, %.1f%% of time, peak %u mA\n",
+           stats.frames_shown,
+           Share(stats.led_us, total),
+           stats.led_peak_ma);
+    printf("mpu               : %.0f uA average\n", total ? static_cast<double>(stats.mpu_ua_us) / total : 0.);
+    printf("delay             : %.1f%% of time\n", Share(stats.delay_us, total));
+    printf("sleep             : %u sleeps, %.1f%% of time\n", stats.sleeps, Share(stats.sleep_us, total));
+    printf("idle              : %u sleeps, %.1f%% of time\n", stats.idles, Share(stats.idle_us, total));
+    printf("adc               : %u conversions\n", stats.adc_conversions);
+    printf("eeprom            : %u writes\n", stats.eeprom_writes);
+
+    for (uint8_t i = 0; i < scheduler->GetTaskCount(); ++i) {
+        printf("task %-12s : %lu runs, %lu overruns, max %lu us late\n",
+               TaskName(i),
+               scheduler->GetRuns(i),
+               scheduler->GetOverruns(i),
+               scheduler->GetMaxLateMicros(i));
+    }
+
+    // Time in each state, as `DutyCycle` counts it between idles: the time
+    // powered down in SleepTransition is left out.
+    printf("\n%-20s %10s %10s\n", "state", "seconds", "awake");
+    for (uint8_t i = 0; i < DutyCycle::kStates; ++i) {
+        Stecchino::State state     = static_cast<Stecchino::State>(i);
+        unsigned long    awake_ms  = duty_cycle->GetAwakeMillis(state);
+        unsigned long    asleep_ms = duty_cycle->GetAsleepMillis(state);
+        if (awake_ms + asleep_ms > 0) {
+            printf("%-20s %10.1f %9.1f%%\n",
+                   StateName(state),
+                   (awake_ms + asleep_ms) / 1e3,
+                   Share(awake_ms, awake_ms + asleep_ms));
+        }
+    }
+
+    if (options.eeprom != nullptr) {
+        SaveEeprom(options.eeprom);
+    }
+
+    return 0;
+}
@@ -0,0 +1,75 @@
+#!/bin/sh
+# Runs the firmware in the native build and checks its output against what is
+# known to be right, exiting non-zero on the first failure.
+#
+#   native/tests/sim_checks.sh
+#
+# Builds the `native` env with the firmware's default configuration.
+
+set -e
+
+cd "$(dirname "$0")/../.."
+
+platformio run --silent --environment native
+program=.pioenvs/native/program
+
+fail() {
+    echo "FAIL: $*" >&2
+    exit 1
+}
+
+# With LED_POWER_BUDGET, every frame still goes out at a visible brightness,
+# from a battery low enough for the warning up to a full charge.
+check_led_budget() {
+    for vcc in 2600 3350; do
+        dark=$("$program" --seconds 600 --vcc "$vcc" --frames | grep -c ' frame .* brightness=0$' || true)
+        [ "$dark" -eq 0 ] || fail "$dark frames at brightness 0 with Vcc at $vcc mV"
+    done
+    echo "ok: LED power budget"
+}
+
+# Replaying a recorded session, Behavior takes the same transitions as the
+# baseline, each within 50 ms of it. States left within a frame are skipped
+# on either side, the firmware may pass straight through them.
+#
+# `session.trace` is the scripted session, recorded for 170 s with
+# `-DSENSOR_TRACE=1 -DMPU_SAMPLE_RATE_HZ=100` and `tools/sensor_trace.py
+# extract`.
+check_replay_states() {
+    "$program" --states --replay native/tests/session.trace | grep ' state ' |
+        awk -v tolerance=0.05 '
+            /^#/ { next }
+            NR == FNR { expected_time[e] = $1; expected_name[e++] = $3; next }
+            { actual_time[a] = $1; actual_name[a++] = $3 }
+
+            function skip(times, i, count) {
+                return i + 1 < count && times[i + 1] - times[i] < 0.01
+            }
+
+            END {
+                i = 0
+                j = 0
+                while (1) {
+                    while (i < e && skip(expected_time, i, e)) i++
+                    while (j < a && skip(actual_time, j, a)) j++
+                    if (i == e || j == a) break
+                    if (expected_name[i] != actual_name[j] || actual_time[j] - expected_time[i] > tolerance ||
+                        expected_time[i] - actual_time[j] > tolerance) {
+                        printf "expected %s at %s, got %s at %s\n", expected_name[i], expected_time[i],
+                            actual_name[j], actual_time[j]
+                        exit 1
+                    }
+                    i++
+                    j++
+                }
+                if (i < e || j < a) {
+                    print "the timelines have different lengths"
+                    exit 1
+                }
+            }' native/tests/session.states - ||
+        fail "the state timeline of native/tests/session.trace changed"
+    echo "ok: replayed state timeline"
+}
+
+check_led_budget
+check_replay_states
@@ -1,20 +1,67 @@
 #include "batteryLevel.h"
 
 #include <Arduino.h>
+#include <avr/interrupt.h>
 
-#include "ArduinoLog.h"
 #include "configuration.h"
+#include "logging.h"
 
-BatteryLevel::BatteryLevel(void){};
+#define LOG_MODULE_LEVEL LOG_LEVEL_BATTERY_LEVEL
 
-int BatteryLevel::GetMillivoltsForDisplay(void) const {
-    Log.trace(F("BatteryLevel::GetMillivoltsForDisplay(): start\n"));
+namespace {
+
+// Result of the last conversion, 0 once taken.
+volatile uint16_t conversion_result = 0;
+
+}  // namespace
+
+ISR(ADC_vect) {
+    // Must read ADCL first - it then locks ADCH.
+    uint8_t low = ADCL;
+
+    // Reading ADCH then unlocks both.
+    uint8_t high = ADCH;
+
+    conversion_result = (high << 8) | low;
+}
+
+BatteryLevel::BatteryLevel(void) : filtered_mv_(0) {}
 
-    int vcc = static_cast<int>(this->ReadVcc());
+void BatteryLevel::Setup(void) {
+    LOG_TRACE("BatteryLevel::Setup\n");
+
+    SelectBandgap();
+
+    // Wait for Vref to settle.
+    delay(2);
+
+    StartConversion();
+
+    while (bit_is_set(ADCSRA, ADSC)) {
+        // Measuring.
+    }
+
+    filtered_mv_ = static_cast<uint32_t>(TakeMillivolts()) << BATTERY_FILTER_SHIFT;
+
+    StartConversion();
+}
 
-    Log.notice(F("VCC    : %dmV\n"), vcc);
-    Log.notice(F("MIN_VCC: %dmV\n"), MIN_VCC_MV);
-    Log.notice(F("MAX_VCC: %dmV\n"), MAX_VCC_MV);
+void BatteryLevel::Update(void) {
+    LOG_TRACE("BatteryLevel::Update\n");
+
+    int millivolts = TakeMillivolts();
+    if (millivolts != 0) {
+        Filter(millivolts);
+    }
+
+    // Still converting if the last `Update()` was too recent, e.g. after sleep.
+    if (!bit_is_set(ADCSRA, ADSC)) {
+        StartConversion();
+    }
+}
+
+int BatteryLevel::GetMillivoltsForDisplay(void) const {
+    int vcc = GetMillivolts();
 
     if (vcc < MIN_VCC_MV) {
         vcc = MIN_VCC_MV;
@@ -22,16 +69,12 @@ int BatteryLevel::GetMillivoltsForDisplay(void) const {
         vcc = MAX_VCC_MV;
     }
 
-    Log.trace(F("BatteryLevel::MillivoltsForDisplay(): end\n"));
-
     return vcc;
 }
 
-long BatteryLevel::ReadVcc(void) const {
-    Log.trace(F("BatteryLevel::ReadVcc(): start\n"));
-
-    // Read 1.1V reference against AVcc. Set the reference to Vcc
-    // and the measurement to the internal 1.1V reference.
+// Set the reference to Vcc and the measurement to the internal 1.1V
+// reference. Nothing else uses the ADC, so it stays selected.
+void BatteryLevel::SelectBandgap(void) {
 #if defined(__AVR_ATmega32U4__) || defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
     ADMUX = _BV(REFS0) | _BV(MUX4) | _BV(MUX3) | _BV(MUX2) | _BV(MUX1);
 #elif defined(__AVR_ATtiny24__) || defined(__AVR_ATtiny44__) || defined(__AVR_ATtiny84__)
@@ -41,30 +84,29 @@ long BatteryLevel::ReadVcc(void) const {
 #else
     ADMUX = _BV(REFS0) | _BV(MUX3) | _BV(MUX2) | _BV(MUX1);
 #endif
+}
 
-    // Wait for Vref to settle.
-    delay(2);
+void BatteryLevel::StartConversion(void) {
+    ADCSRA |= _BV(ADIE) | _BV(ADSC);
+}
 
-    // Start conversion.
-    ADCSRA |= _BV(ADSC);
+int BatteryLevel::TakeMillivolts(void) {
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t result   = conversion_result;
+    conversion_result = 0;
+    SREG              = sreg;
 
-    while (bit_is_set(ADCSRA, ADSC)) {
-        // Measuring.
+    if (result == 0) {
+        return 0;
     }
 
-    // Must read ADCL first - it then locks ADCH.
-    uint8_t low = ADCL;
-
-    // Reading ADCH then unlocks both.
-    uint8_t high = ADCH;
-
-    long result = (high << 8) | low;
-
     // Calculate Vcc (in mV); 1125300 = 1.1 * 1023 * 1000
-    result = 1125300L / result;
+    return static_cast<int>(1125300L / result);
+}
 
-    Log.trace(F("BatteryLevel::ReadVcc(): end\n"));
+void BatteryLevel::Filter(const int millivolts) {
+    filtered_mv_ = filtered_mv_ - (filtered_mv_ >> BATTERY_FILTER_SHIFT) + static_cast<uint32_t>(millivolts);
 
-    // Vcc in millivolts.
-    return result;
+    LOG_VERBOSE("VCC: %dmV, filtered %dmV\n", millivolts, GetMillivolts());
 }
@@ -1,11 +1,40 @@
 #pragma once
 
+#include <stdint.h>
+
+#include "configuration.h"
+
+// Vcc, measured as the internal 1.1V bandgap against AVcc.
+//
+// `Update()`, run every `BATTERY_REFRESH_MS`, collects the conversion the
+// last call started, filters it into the cached value, and starts the next
+// one: the ADC converts in the background and its interrupt stores the
+// result, so no caller waits on it.
 class BatteryLevel {
   public:
     BatteryLevel(void);
 
+    // Takes a first, blocking, reading so the value is valid from the start.
+    void Setup(void);
+
+    void Update(void);
+
+    // Filtered Vcc, as of the last `Update()`.
+    int GetMillivolts(void) const { return static_cast<int>(filtered_mv_ >> BATTERY_FILTER_SHIFT); }
+
+    // Filtered Vcc clamped to the displayed range.
     int GetMillivoltsForDisplay(void) const;
 
   private:
-    long ReadVcc(void) const;
+    // Sum of the last 2^BATTERY_FILTER_SHIFT readings, exponentially weighted.
+    uint32_t filtered_mv_;
+
+    static void SelectBandgap(void);
+
+    static void StartConversion(void);
+
+    // Returns the reading of the finished conversion in mV, or 0 if there is none.
+    static int TakeMillivolts(void);
+
+    void Filter(const int millivolts);
 };
@@ -1,67 +1,132 @@
 #include "behavior.h"
 
 #include <Arduino.h>
-#include <ArduinoLog.h>
+#include <avr/pgmspace.h>
 #include <avr/sleep.h>
 
 #include "batteryLevel.h"
 #include "configuration.h"
 #include "ledStrip.h"
+#include "logging.h"
 #include "mpu.h"
+#include "scheduler.h"
 #include "stecchino.h"
 
+#define LOG_MODULE_LEVEL LOG_LEVEL_BEHAVIOR
+
 volatile bool Behavior::interrupted_ = false;
 
-Behavior::Behavior(LedStrip * led_strip, Mpu * mpu, BatteryLevel * battery_level)
-    : state_(Stecchino::State::kUnknown), led_strip_(led_strip), mpu_(mpu), battery_level_(battery_level) {}
+const Behavior::Transition Behavior::kTransitions[] PROGMEM = {
+    {Stecchino::State::kCheckBattery, Event::kTimeout, nullptr, nullptr, Stecchino::State::kIdle},
+
+    {Stecchino::State::kIdle, Event::kTimeout, nullptr, nullptr, Stecchino::State::kFakeSleep},
+    {Stecchino::State::kIdle, Event::kStraight, nullptr, nullptr, Stecchino::State::kStartPlayTransition},
+    {Stecchino::State::kIdle, Event::kOrientation, &Behavior::IsLongEdgeDown, nullptr, Stecchino::State::kSpiritLevel},
+    {Stecchino::State::kIdle,
+     Event::kOrientation,
+     &Behavior::IsButtonsDown,
+     nullptr,
+     Stecchino::State::kSleepTransition},
+
+    {Stecchino::State::kStartPlayTransition, Event::kTimeout, nullptr, &Behavior::KeepRecord, Stecchino::State::kPlay},
+
+    {Stecchino::State::kPlay, Event::kTimeout, nullptr, nullptr, Stecchino::State::kSleepTransition},
+    {Stecchino::State::kPlay, Event::kFallen, nullptr, nullptr, Stecchino::State::kGameOverTransition},
+
+    {Stecchino::State::kGameOverTransition, Event::kTimeout, nullptr, nullptr, Stecchino::State::kIdle},
+
+    {Stecchino::State::kSpiritLevel, Event::kOrientation, &Behavior::IsLyingFlat, nullptr, Stecchino::State::kIdle},
+    {Stecchino::State::kSpiritLevel, Event::kTimeout, nullptr, nullptr, Stecchino::State::kFakeSleep},
+
+#if FAKE_SLEEP_POWER_DOWN
+    // Doze until moved, then check again, this continues when interrupted.
+    {Stecchino::State::kFakeSleep, Event::kTimeout, nullptr, &Behavior::Doze, Stecchino::State::kFakeSleep},
+#else
+    {Stecchino::State::kFakeSleep, Event::kTimeout, nullptr, nullptr, Stecchino::State::kSleepTransition},
+#endif
+    {Stecchino::State::kFakeSleep, Event::kTilted, nullptr, nullptr, Stecchino::State::kIdle},
+
+    // Go to sleep, this continues when interrupted.
+    {Stecchino::State::kSleepTransition, Event::kTimeout, nullptr, &Behavior::Sleep, Stecchino::State::kCheckBattery},
+};
+
+// FakeSleep keeps the strip as blanked on entering it. Only the game itself
+// needs the full sample rate, the other states wait for the stick to be
+// picked up or stood up, and the battery level not even that.
+// SleepTransition keeps it for the sleep: cycling, the motion interrupt's
+// duration would count wake-ups rather than milliseconds.
+const Behavior::StateInfo Behavior::kStates[] PROGMEM = {
+    {Stecchino::State::kCheckBattery, MAX_SHOW_BATTERY_MS, Mpu::Profile::kCycle5Hz, &Behavior::DrawBatteryLevel},
+#if FAKE_SLEEP_POWER_DOWN
+    {Stecchino::State::kFakeSleep, FAKE_SLEEP_AWAKE_MS, Mpu::Profile::kCycle20Hz, nullptr},
+#else
+    {Stecchino::State::kFakeSleep, MAX_FAKE_SLEEP_MS, Mpu::Profile::kCycle20Hz, nullptr},
+#endif
+    {Stecchino::State::kGameOverTransition,
+     MAX_GAME_OVER_TRANSITION_MS,
+     Mpu::Profile::kCycle40Hz,
+     &Behavior::DrawGameOver},
+    {Stecchino::State::kIdle, MAX_IDLE_MS, Mpu::Profile::kCycle40Hz, &Behavior::DrawIdle},
+    {Stecchino::State::kPlay, MAX_PLAY_MS, Mpu::Profile::kFull, &Behavior::DrawPlay},
+    {Stecchino::State::kSleepTransition, MAX_SLEEP_TRANSITION_MS, Mpu::Profile::kFull, &Behavior::DrawGoingToSleep},
+    {Stecchino::State::kSpiritLevel, MAX_SPIRIT_LEVEL_MS, Mpu::Profile::kCycle20Hz, &Behavior::DrawSpiritLevel},
+    {Stecchino::State::kStartPlayTransition,
+     MAX_START_PLAY_TRANSITION_MS,
+     Mpu::Profile::kFull,
+     &Behavior::DrawStartPlay},
+};
+
+Behavior::Behavior(LedStrip *     led_strip,
+                   Mpu *          mpu,
+                   BatteryLevel * battery_level,
+                   Scheduler *    scheduler,
+                   int8_t         timer)
+    : state_(Stecchino::State::kUnknown),
+      led_strip_(led_strip),
+      mpu_(mpu),
+      battery_level_(battery_level),
+      scheduler_(scheduler),
+      timer_(timer),
+      angle_to_horizon_(0),
+      accel_status_(Stecchino::AccelStatus::kUnknown),
+      orientation_(Stecchino::Orientation::kUnknown) {}
 
 void Behavior::Setup(void) {
     SetState(Stecchino::State::kCheckBattery);
 }
 
-void Behavior::Update(const float                  angle_to_horizon,
+void Behavior::Update(const int16_t                angle_to_horizon,
                       const Stecchino::AccelStatus accel_status,
                       const Stecchino::Orientation orientation) {
-    Log.trace(F("Behavior::Update\n"));
-
-    switch (state_) {
-        case Stecchino::State::kCheckBattery: {
-            CheckBattery();
-        } break;
-
-        case Stecchino::State::kIdle: {
-            Idle(accel_status, orientation);
-        } break;
-
-        case Stecchino::State::kStartPlayTransition: {
-            StartPlayTransition();
-        } break;
-
-        case Stecchino::State::kPlay: {
-            Play(accel_status);
-        } break;
-
-        case Stecchino::State::kGameOverTransition: {
-            GameOverTransition();
-        } break;
-
-        case Stecchino::State::kSpiritLevel: {
-            SpiritLevel(angle_to_horizon, orientation);
-        } break;
-
-        case Stecchino::State::kFakeSleep: {
-            FakeSleep(angle_to_horizon);
-        } break;
-
-        case Stecchino::State::kSleepTransition: {
-            SleepTransition();
-        } break;
-
-        default: {
-            // If we don't know what to do, check the battery.
-            Log.error(F("Unknown state [%d], defaulting to CheckBattery\n"), static_cast<int>(state_));
-            SetState(Stecchino::State::kCheckBattery);
-        } break;
+    LOG_TRACE("Behavior::Update\n");
+
+    angle_to_horizon_ = angle_to_horizon;
+    accel_status_     = accel_status;
+    orientation_      = orientation;
+
+    if (state_ == Stecchino::State::kUnknown) {
+        // If we don't know what to do, check the battery.
+        LOG_ERROR("Unknown state [%d], defaulting to CheckBattery\n", static_cast<int>(state_));
+        SetState(Stecchino::State::kCheckBattery);
+        return;
+    }
+
+    DispatchEvents();
+}
+
+void Behavior::Expire(void) {
+    LOG_TRACE("Behavior::Expire\n");
+
+    // The readings may already raise an event in the state entered.
+    if (Dispatch(true)) {
+        DispatchEvents();
+    }
+}
+
+void Behavior::Draw(void) {
+    Action draw = GetStateInfo(state_).draw;
+    if (draw != nullptr) {
+        (this->*draw)();
     }
 }
 
@@ -71,31 +136,96 @@ void Behavior::SetState(const Stecchino::State state) {
     start_time_     = millis();
 
     led_strip_->Off();
+
+    StateInfo info = GetStateInfo(state);
+    mpu_->SetProfile(info.profile);
+
+    if (info.timeout_ms > 0) {
+        scheduler_->StartTimer(timer_, 1000UL * info.timeout_ms);
+    } else {
+        scheduler_->StopTimer(timer_);
+    }
 }
 
 bool Behavior::IsNewState(void) const {
     return (state_ == previous_state_);
 }
 
+Behavior::StateInfo Behavior::GetStateInfo(const Stecchino::State state) {
+    StateInfo info;
+    for (uint8_t i = 0; i < ARRAY_SIZE(kStates); ++i) {
+        memcpy_P(&info, &kStates[i], sizeof(info));
+        if (info.state == state) {
+            return info;
+        }
+    }
+
+    info = {state, 0, Mpu::Profile::kFull, nullptr};
+    return info;
+}
+
+bool Behavior::Dispatch(const bool timeout) {
+    for (uint8_t i = 0; i < ARRAY_SIZE(kTransitions); ++i) {
+        Transition transition;
+        memcpy_P(&transition, &kTransitions[i], sizeof(transition));
+
+        if (transition.from != state_ || (transition.event == Event::kTimeout) != timeout) {
+            continue;
+        }
+        if (!timeout && !IsRaised(transition.event)) {
+            continue;
+        }
+        if (transition.guard != nullptr && !(this->*transition.guard)()) {
+            continue;
+        }
+
+        if (transition.action != nullptr) {
+            (this->*transition.action)();
+        }
+        SetState(transition.to);
+        return true;
+    }
+
+    return false;
+}
+
+void Behavior::DispatchEvents(void) {
+    // No state is both entered and left on the same readings, this ends.
+    while (Dispatch(false)) {
+    }
+}
+
+bool Behavior::IsRaised(const Event event) const {
+    switch (event) {
+        case Event::kStraight:
+            return accel_status_ == Stecchino::AccelStatus::kStraight;
+        case Event::kFallen:
+            return accel_status_ == Stecchino::AccelStatus::kFallen;
+        case Event::kOrientation:
+            return true;
+        case Event::kTilted:
+            return abs(angle_to_horizon_) > 15;
+        default:
+            return false;
+    }
+}
+
 void Behavior::PinInterrupt(void) {
-    Log.trace(F("PinInterrupt()\n"));
+    LOG_TRACE("PinInterrupt()\n");
 
     if (Behavior::interrupted_) {
-        Log.notice(F("Interrupted, disabling interrupt\n"));
+        LOG_NOTICE("Interrupted, disabling interrupt\n");
         detachInterrupt(digitalPinToInterrupt(PIN_INTERRUPT));
     }
 }
 
 void Behavior::Sleep(void) {
-    Log.trace(F("Behavior::Sleep()\n"));
+    LOG_TRACE("Behavior::Sleep()\n");
 
-    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
-    sleep_enable();
-
-    Behavior::interrupted_ = false;
-    attachInterrupt(digitalPinToInterrupt(PIN_INTERRUPT), PinInterrupt, LOW);
+    // The INT pin is shared with the data-ready interrupt, switch it to motion.
+    mpu_->StopSampling();
 
-    Log.trace(F("powering down\n"));
+    LOG_TRACE("powering down\n");
 
     // Put the device to sleep:
     digitalWrite(PIN_MOSFET_GATE, LOW);  // Turn LEDs off to indicate sleep.
@@ -104,89 +234,103 @@ void Behavior::Sleep(void) {
     // XXX digitalWrite(PIN_MPU_POWER, LOW);
     delay(100);  // XXX needed?
 
-    Log.trace(F("sleeping\n"));
-
-    Serial.flush();
-    sleep_mode();
-
-    // Upon waking up, sketch continues from this point.
-    Log.trace(F("woke\n"));
-    Behavior::interrupted_ = true;
-    sleep_disable();
+    PowerDown();
 
     // Turn LEDs on to indicate awake.
     digitalWrite(PIN_MOSFET_GATE, HIGH);
+    led_strip_->Invalidate();
 
     // Turn MPU on.
     // XXX digitalWrite(PIN_MPU_POWER, HIGH);
 
     delay(100);  // XXX needed?
+
+    mpu_->StartSampling();
+
+    // The ticks slept through were not missed.
+    scheduler_->Resync();
 }
-void Behavior::CheckBattery(void) {
-    Log.trace(F("Behavior::CheckBattery\n"));
 
-    if (millis() - start_time_ > MAX_SHOW_BATTERY_MS) {
-        SetState(Stecchino::State::kIdle);
-        return;
-    }
+#if FAKE_SLEEP_POWER_DOWN
+void Behavior::Doze(void) {
+    LOG_TRACE("Behavior::Doze()\n");
 
-    int vcc = battery_level_->GetMillivoltsForDisplay();
-    led_strip_->ShowBatteryLevel(vcc);
+    mpu_->StopSamplingForDoze();
+
+    // The strip is dark in FakeSleep, cut its power too.
+    digitalWrite(PIN_MOSFET_GATE, LOW);
+
+    // Coming to rest interrupts too, sleep on through it.
+    do {
+        PowerDown();
+    } while (!mpu_->HasMoved());
+
+    digitalWrite(PIN_MOSFET_GATE, HIGH);
+    led_strip_->Invalidate();
+
+    mpu_->StartSampling();
+
+    scheduler_->Resync();
 }
+#endif
 
-void Behavior::Idle(const Stecchino::AccelStatus accel_status, const Stecchino::Orientation orientation) {
-    Log.trace(F("Behavior::Idle\n"));
+void Behavior::PowerDown(void) {
+    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+    sleep_enable();
 
-    if (millis() - start_time_ > MAX_IDLE_MS) {
-        SetState(Stecchino::State::kFakeSleep);
-        return;
-    }
+    Behavior::interrupted_ = false;
+    attachInterrupt(digitalPinToInterrupt(PIN_INTERRUPT), PinInterrupt, LOW);
 
-    if (accel_status == Stecchino::AccelStatus::kStraight) {
-        SetState(Stecchino::State::kStartPlayTransition);
-        return;
-    }
+    LOG_TRACE("sleeping\n");
 
-    if (orientation == Stecchino::Orientation::kPosition_3) {
-        SetState(Stecchino::State::kSpiritLevel);
-        return;
-    }
+    Serial.flush();
+    sleep_mode();
 
-    if (orientation == Stecchino::Orientation::kPosition_2) {
-        SetState(Stecchino::State::kSleepTransition);
-        return;
-    }
+    // Upon waking up, sketch continues from this point.
+    LOG_TRACE("woke\n");
+    Behavior::interrupted_ = true;
+    sleep_disable();
+}
 
-    led_strip_->ShowIdle();
+bool Behavior::IsButtonsDown(void) const {
+    return orientation_ == Stecchino::Orientation::kPosition_2;
+}
+
+bool Behavior::IsLongEdgeDown(void) const {
+    return orientation_ == Stecchino::Orientation::kPosition_3;
 }
 
-void Behavior::StartPlayTransition(void) {
-    Log.trace(F("Behavior::StartPlayTransition\n"));
+bool Behavior::IsLyingFlat(void) const {
+    return orientation_ == Stecchino::Orientation::kPosition_1 || orientation_ == Stecchino::Orientation::kPosition_2;
+}
 
-    if (millis() - start_time_ > MAX_START_PLAY_TRANSITION_MS) {
-        previous_record_time_ = record_time_;
+void Behavior::KeepRecord(void) {
+    previous_record_time_ = record_time_;
+}
 
-        SetState(Stecchino::State::kPlay);
-        return;
-    }
+void Behavior::DrawBatteryLevel(void) {
+    LOG_TRACE("Behavior::DrawBatteryLevel\n");
 
-    led_strip_->ShowStartPlay();
+    int vcc = battery_level_->GetMillivoltsForDisplay();
+    led_strip_->ShowBatteryLevel(vcc);
 }
 
-void Behavior::Play(const Stecchino::AccelStatus accel_status) {
-    Log.trace(F("Behavior::Play\n"));
+void Behavior::DrawIdle(void) {
+    LOG_TRACE("Behavior::DrawIdle\n");
 
-    unsigned long elapsed_time = millis() - start_time_;
+    led_strip_->ShowIdle();
+}
 
-    if (elapsed_time > MAX_PLAY_MS) {
-        SetState(Stecchino::State::kSleepTransition);
-        return;
-    }
+void Behavior::DrawStartPlay(void) {
+    LOG_TRACE("Behavior::DrawStartPlay\n");
 
-    if (accel_status == Stecchino::AccelStatus::kFallen) {
-        SetState(Stecchino::State::kGameOverTransition);
-        return;
-    }
+    led_strip_->ShowStartPlay();
+}
+
+void Behavior::DrawPlay(void) {
+    LOG_TRACE("Behavior::DrawPlay\n");
+
+    unsigned long elapsed_time = millis() - start_time_;
 
     if (elapsed_time > record_time_) {
         record_time_ = elapsed_time;
@@ -205,65 +349,20 @@ void Behavior::Play(const Stecchino::AccelStatus accel_status) {
     }
 }
 
-void Behavior::GameOverTransition(void) {
-    Log.trace(F("Behavior::GameOverTransition\n"));
-
-    if (millis() - start_time_ > MAX_GAME_OVER_TRANSITION_MS) {
-        SetState(Stecchino::State::kIdle);
-        return;
-    }
+void Behavior::DrawGameOver(void) {
+    LOG_TRACE("Behavior::DrawGameOver\n");
 
     led_strip_->ShowPattern(LedStrip::Pattern::kGameOver);
 }
 
-void Behavior::SpiritLevel(const float angle_to_horizon, const Stecchino::Orientation orientation) {
-    Log.trace(F("Behavior::SpiritLevel\n"));
-
-    if (orientation == Stecchino::Orientation::kPosition_1 || orientation == Stecchino::Orientation::kPosition_2) {
-        SetState(Stecchino::State::kIdle);
-        return;
-    }
-
-    if (millis() - start_time_ > MAX_SPIRIT_LEVEL_MS) {
-        SetState(Stecchino::State::kFakeSleep);
-        return;
-    }
-
-    led_strip_->ShowSpiritLevel(angle_to_horizon);
-}
-
-void Behavior::FakeSleep(const float angle_to_horizon) {
-    Log.trace(F("Behavior::FakeSleep\n"));
-
-    if (millis() - start_time_ > MAX_FAKE_SLEEP_MS) {
-        SetState(Stecchino::State::kSleepTransition);
-        return;
-    }
-
-    if (abs(angle_to_horizon) > 15) {
-        SetState(Stecchino::State::kIdle);
-        return;
-    }
+void Behavior::DrawSpiritLevel(void) {
+    LOG_TRACE("Behavior::DrawSpiritLevel\n");
 
-    led_strip_->Off();
+    led_strip_->ShowSpiritLevel(angle_to_horizon_);
 }
 
-void Behavior::SleepTransition(void) {
-    Log.trace(F("Behavior::SleepTransition\n"));
+void Behavior::DrawGoingToSleep(void) {
+    LOG_TRACE("Behavior::DrawGoingToSleep\n");
 
-    if (millis() - start_time_ <= MAX_SLEEP_TRANSITION_MS) {
-        led_strip_->ShowGoingToSleep();
-        return;
-    }
-
-    // Go to sleep. This will continue when interrupted.
-    Sleep();
-
-    // position_->ClearSampleBuffer();
-
-    // Restore MPU connection.
-    // XXX Log.notice(F("Restarting MPU\n"));
-    // XXX mpu_->Setup();
-
-    SetState(Stecchino::State::kCheckBattery);
+    led_strip_->ShowGoingToSleep();
 }
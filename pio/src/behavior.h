@@ -1,23 +1,75 @@
 #pragma once
 
 #include "batteryLevel.h"
+#include "configuration.h"
 #include "ledStrip.h"
 #include "mpu.h"
+#include "scheduler.h"
 #include "stecchino.h"
 
+// The game as a state machine, driven by the transition table `kTransitions`.
+//
+// Each state may have a time limit, `kStates`, scheduled on `timer` when the
+// state is entered along with the MPU profile it samples at: `Expire()` is
+// what the timer runs. The sensor readings are raised as events by
+// `Update()`, as they change, and again in each state entered while they
+// hold. `Draw()` draws the state's frame, if it animates.
 class Behavior {
   public:
-    Behavior(LedStrip * led_strip, Mpu * mpu, BatteryLevel * battery_level);
+    Behavior(LedStrip * led_strip, Mpu * mpu, BatteryLevel * battery_level, Scheduler * scheduler, int8_t timer);
 
     void Setup(void);
 
-    void Update(const float                  angle_to_horizon,
+    void Update(const int16_t                angle_to_horizon,
                 const Stecchino::AccelStatus accel_status,
                 const Stecchino::Orientation orientation);
 
+    // The current state's time limit passed.
+    void Expire(void);
+
+    // Draw a frame of the current state, if it animates.
+    void Draw(void);
+
     Stecchino::State GetState() const { return state_; };
 
   private:
+    enum class Event : uint8_t {
+        // The state's time limit passed.
+        kTimeout,
+        kStraight,
+        kFallen,
+        // Any orientation, for the guards to tell apart.
+        kOrientation,
+        // More than 15° off horizontal.
+        kTilted,
+    };
+
+    typedef bool (Behavior::*Guard)(void) const;
+    typedef void (Behavior::*Action)(void);
+
+    // In the current state, the first transition whose event is raised and
+    // guard, if any, holds runs its action, if any, and enters its state.
+    struct Transition {
+        Stecchino::State from;
+        Event            event;
+        Guard            guard;
+        Action           action;
+        Stecchino::State to;
+    };
+
+    struct StateInfo {
+        Stecchino::State state;
+        // 0 for no time limit.
+        unsigned long timeout_ms;
+        // How fast the state needs the stick sampled, with MPU_LOW_POWER.
+        Mpu::Profile profile;
+        // Draws a frame of the state, if it animates.
+        Action draw;
+    };
+
+    static const Transition kTransitions[];
+    static const StateInfo  kStates[];
+
     Stecchino::State previous_state_;
     Stecchino::State state_;
 
@@ -26,9 +78,15 @@ class Behavior {
     LedStrip *     led_strip_;
     Mpu *          mpu_;
     BatteryLevel * battery_level_;
+    Scheduler *    scheduler_;
+    const int8_t   timer_;
+
+    // The readings of the last `Update()`.
+    int16_t                angle_to_horizon_;
+    Stecchino::AccelStatus accel_status_;
+    Stecchino::Orientation orientation_;
 
-    // Track when the current state was entered so we can tell when it's time to
-    // expire the state and transition to a new state.
+    // When the current state was entered, for the animations.
     unsigned long start_time_ = 0;
 
     unsigned long record_time_          = 0;
@@ -39,23 +97,55 @@ class Behavior {
 
     bool IsNewState(void) const;
 
+    static StateInfo GetStateInfo(const Stecchino::State state);
+
+    // Take the first transition for the time limit, or for the sensor events.
+    // Returns true if one was taken.
+    bool Dispatch(const bool timeout);
+
+    // Take the transitions for the sensor events, from each state entered,
+    // until none is raised.
+    void DispatchEvents(void);
+
+    bool IsRaised(const Event event) const;
+
     static void PinInterrupt(void);
 
+    // Sleep until the MPU interrupts.
+    void PowerDown(void);
+
+    // Guards.
+
+    bool IsButtonsDown(void) const;
+
+    bool IsLongEdgeDown(void) const;
+
+    bool IsLyingFlat(void) const;
+
+    // Actions.
+
     void Sleep(void);
 
-    void CheckBattery(void);
+#if FAKE_SLEEP_POWER_DOWN
+    // Sleep until the stick is moved or dropped, in FakeSleep.
+    void Doze(void);
+#endif
+
+    void KeepRecord(void);
+
+    // Frames.
 
-    void Idle(const Stecchino::AccelStatus accel_status, const Stecchino::Orientation orientation);
+    void DrawBatteryLevel(void);
 
-    void StartPlayTransition(void);
+    void DrawIdle(void);
 
-    void Play(const Stecchino::AccelStatus accel_status);
+    void DrawStartPlay(void);
 
-    void GameOverTransition(void);
+    void DrawPlay(void);
 
-    void SpiritLevel(const float angle_to_horizon, const Stecchino::Orientation orientation);
+    void DrawGameOver(void);
 
-    void FakeSleep(const float angle_to_horizon);
+    void DrawSpiritLevel(void);
 
-    void SleepTransition(void);
+    void DrawGoingToSleep(void);
 };
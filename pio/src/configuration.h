@@ -13,9 +13,122 @@
 // Number of LEDs to turn on every second when playing.
 #define NUM_LEDS_PER_SECOND 2
 
+// SRAM the globals must leave free for the stack, checked after each build by
+// `tools/memory_map.py`.
+#define SRAM_HEADROOM_BYTES 512
+
 // LED animation speed.
 #define FRAMES_PER_SECOND 120
 
+// The sensor pipeline settings can be overridden from the build flags, as
+// `tools/fall_latency_sweep.sh` does.
+
+// MPU accelerometer output data rate, into its FIFO. Must divide 1000.
+#ifndef MPU_SAMPLE_RATE_HZ
+#    define MPU_SAMPLE_RATE_HZ 200
+#endif
+
+// Number of MPU samples to collect before draining the FIFO in one burst.
+#ifndef MPU_FIFO_BURST_SAMPLES
+#    define MPU_FIFO_BURST_SAMPLES 4
+#endif
+
+// 1 to keep the MPU's gyros in standby, which Position only reads with
+// POSITION_FUSION or POSITION_DMP, and to sample the accelerometer in its
+// low-power cycle mode outside play, at the rate each Behavior state asks
+// for. See `Mpu::Profile` for the current each draws.
+#ifndef MPU_LOW_POWER
+#    define MPU_LOW_POWER 0
+#endif
+
+// Number of samples in the running median of each accel axis.
+#ifndef POSITION_MEDIAN_WINDOW
+#    define POSITION_MEDIAN_WINDOW 5
+#endif
+
+// 1 to take Position from the gravity vector the MPU's DMP fuses from the
+// accelerometer and gyro, instead of from the accel medians. Costs the 1.9KB
+// DMP image in flash, and a 42-byte FIFO read per packet.
+#ifndef POSITION_DMP
+#    define POSITION_DMP 0
+#endif
+
+// DMP packets per second with POSITION_DMP. Must divide the DMP's 200Hz.
+#ifndef POSITION_DMP_RATE_HZ
+#    define POSITION_DMP_RATE_HZ 100
+#endif
+
+// 1 to take Position from `TiltFilter`, fusing the gyro with the accelerometer
+// in fixed point on the MCU, instead of from the accel medians. Reads the gyro
+// into the FIFO too, 12 bytes per sample.
+#ifndef POSITION_FUSION
+#    define POSITION_FUSION 0
+#endif
+
+// With POSITION_FUSION, each sample pulls the estimate toward the
+// accelerometer by 1/2^POSITION_FUSION_PULL_SHIFT, over about 0.64s at 200Hz,
+// and moves the gyro bias by the disagreement >> POSITION_FUSION_BIAS_SHIFT,
+// settling it over about 10s.
+#define POSITION_FUSION_PULL_SHIFT 7
+#define POSITION_FUSION_BIAS_SHIFT 11
+
+// 1 to end the game as soon as `FallPredictor` is FALL_PREDICTION_MIN_CONFIDENCE
+// sure the stick is falling, rather than once it passes 45°. It projects the
+// tilt FALL_PREDICTION_HORIZON_MS ahead and ignores leans under
+// FALL_PREDICTION_MIN_TILT hundredths of a degree. See
+// `native/benchmarks/fallPrediction` for the lead time and false calls of
+// each confidence.
+#ifndef FALL_PREDICTION
+#    define FALL_PREDICTION 0
+#endif
+#ifndef FALL_PREDICTION_MIN_CONFIDENCE
+#    define FALL_PREDICTION_MIN_CONFIDENCE 160
+#endif
+#ifndef FALL_PREDICTION_HORIZON_MS
+#    define FALL_PREDICTION_HORIZON_MS 100
+#endif
+#define FALL_PREDICTION_MIN_TILT 1500
+
+// How often Position checks for a full burst of MPU samples.
+#define POSITION_UPDATES_PER_SECOND 200
+
+// Log level of each module, from LOG_LEVEL_SILENT to LOG_LEVEL_VERBOSE. Log
+// calls above their module's level compile to nothing.
+#define LOG_LEVEL_BATTERY_LEVEL LOG_LEVEL_WARNING
+#define LOG_LEVEL_BEHAVIOR LOG_LEVEL_NOTICE
+#define LOG_LEVEL_DISCHARGE_LOG LOG_LEVEL_NOTICE
+#define LOG_LEVEL_DUTY_CYCLE LOG_LEVEL_NOTICE
+#define LOG_LEVEL_LED_STRIP LOG_LEVEL_WARNING
+#define LOG_LEVEL_MPU LOG_LEVEL_NOTICE
+#define LOG_LEVEL_POSITION LOG_LEVEL_WARNING
+#define LOG_LEVEL_SCHEDULER LOG_LEVEL_NOTICE
+#define LOG_LEVEL_STECCHINO LOG_LEVEL_NOTICE
+
+// 1 to log compact binary records, decoded on the host by
+// `tools/log_decode.py`, instead of text.
+#ifndef LOG_BINARY
+#    define LOG_BINARY 0
+#endif
+
+// 1 to stream the raw accelerometer samples as binary records, see
+// `sensorTrace.h`, with Serial at SENSOR_TRACE_BAUD.
+#ifndef SENSOR_TRACE
+#    define SENSOR_TRACE 0
+#endif
+#define SENSOR_TRACE_BAUD 115200
+
+// How often to log the scheduler's task counters.
+#define SCHEDULER_REPORT_MS 10000
+
+// 1 to idle the CPU while no task is due, see `dutyCycle.h`. Can be
+// overridden from the build flags to compare.
+#ifndef IDLE_SLEEP
+#    define IDLE_SLEEP 1
+#endif
+
+// LED turn-off wipe speed, one LED per this many ms.
+#define OFF_WIPE_MS_PER_LED 10
+
 // LED high brightness level.
 #define HIGH_BRIGHTNESS 50
 
@@ -28,6 +141,28 @@
 // Maximum Vcc value when reporting battery level.
 #define MAX_VCC_MV 3350
 
+// 1 to dim frames that would draw more than the strip's power budget, which
+// shrinks with Vcc so a low battery doesn't brown out under a bright frame.
+// The budget is in mA, at MAX_VCC_MV and at MIN_VCC_MV.
+#define LED_POWER_BUDGET 1
+#define LED_BUDGET_MAX_VCC_MA 500
+#define LED_BUDGET_MIN_VCC_MA 100
+
+// How often to measure Vcc.
+#define BATTERY_REFRESH_MS 250
+
+// Vcc is filtered over about 2^BATTERY_FILTER_SHIFT readings.
+#define BATTERY_FILTER_SHIFT 2
+
+// 1 to log Vcc with the state and brightness in use to EEPROM, see
+// `dischargeLog.h`, and dump the log to Serial when asked to over it.
+#ifndef DISCHARGE_LOG
+#    define DISCHARGE_LOG 0
+#endif
+
+// On-time covered by each discharge log entry.
+#define DISCHARGE_LOG_PERIOD_S 60
+
 // 0, 1 or 2 to set the angle of the joystick
 #define ACCELEROMETER_ORIENTATION 2
 
@@ -40,6 +175,15 @@
 // How long to be FakeSleep before moving to Sleep.
 #define MAX_FAKE_SLEEP_MS 60000
 
+// 1 to power down in FakeSleep rather than poll the tilt, woken by the MPU's
+// motion, zero-motion and free-fall interrupts. FakeSleep samples for
+// FAKE_SLEEP_AWAKE_MS on entry and after each wake, back to Idle if tilted
+// or else powering down again, so it no longer moves on to Sleep.
+#ifndef FAKE_SLEEP_POWER_DOWN
+#    define FAKE_SLEEP_POWER_DOWN 0
+#endif
+#define FAKE_SLEEP_AWAKE_MS 500
+
 // How long to be SpiritLevel before moving to Sleep.
 #define MAX_SPIRIT_LEVEL_MS 20000
 
@@ -0,0 +1,153 @@
+#include "dischargeLog.h"
+
+#include <EEPROM.h>
+
+#include "logging.h"
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_DISCHARGE_LOG
+
+DischargeLog::DischargeLog(void)
+    : slots_(0),
+      next_slot_(0),
+      next_sequence_(0),
+      state_samples_(),
+      samples_(0),
+      brightness_sum_(0),
+      pending_bytes_(0) {}
+
+void DischargeLog::Setup(void) {
+    LOG_TRACE("DischargeLog::Setup\n");
+
+    slots_ = EEPROM.length() / sizeof(Entry);
+
+    next_slot_     = 0;
+    next_sequence_ = 0;
+
+    // The oldest entry is one its predecessor slot does not lead to.
+    uint16_t oldest = slots_;
+    for (uint16_t slot = 0; slot < slots_ && oldest == slots_; ++slot) {
+        uint8_t sequence = ReadEntry(slot).sequence;
+        if (sequence != kErased && ReadEntry(slot == 0 ? slots_ - 1 : slot - 1).sequence != Previous(sequence)) {
+            oldest = slot;
+        }
+    }
+    if (oldest == slots_) {
+        return;
+    }
+
+    // Follow the sequence to the newest entry.
+    uint16_t slot     = oldest;
+    uint8_t  sequence = ReadEntry(oldest).sequence;
+    for (uint16_t i = 1; i < slots_; ++i) {
+        uint16_t next = slot + 1 == slots_ ? 0 : slot + 1;
+        if (ReadEntry(next).sequence != Next(sequence)) {
+            break;
+        }
+        slot     = next;
+        sequence = Next(sequence);
+    }
+    next_slot_     = slot + 1 == slots_ ? 0 : slot + 1;
+    next_sequence_ = Next(sequence);
+
+    LOG_NOTICE("Discharge log continues at slot %d\n", next_slot_);
+}
+
+void DischargeLog::Sample(const Stecchino::State state, const uint8_t brightness, const int millivolts) {
+    if (pending_bytes_ > 0) {
+        WritePendingByte();
+    }
+
+    ++state_samples_[static_cast<uint8_t>(state)];
+    brightness_sum_ += brightness;
+    if (++samples_ < kSamplesPerEntry) {
+        return;
+    }
+
+    uint8_t mostly = 0;
+    for (uint8_t i = 1; i < Stecchino::kStateCount; ++i) {
+        if (state_samples_[i] > state_samples_[mostly]) {
+            mostly = i;
+        }
+    }
+
+    pending_.sequence   = next_sequence_;
+    pending_.state      = mostly;
+    pending_.brightness = static_cast<uint8_t>(brightness_sum_ / samples_);
+    pending_.vcc        = static_cast<uint8_t>(constrain((millivolts - 2000) / 10, 0, 254));
+    pending_bytes_      = sizeof(Entry) + 1;
+
+    for (uint8_t i = 0; i < Stecchino::kStateCount; ++i) {
+        state_samples_[i] = 0;
+    }
+    samples_        = 0;
+    brightness_sum_ = 0;
+}
+
+void DischargeLog::Dump(Print * output) const {
+    const uint16_t period_s  = DISCHARGE_LOG_PERIOD_S;
+    const uint8_t  period[2] = {static_cast<uint8_t>(period_s), static_cast<uint8_t>(period_s >> 8)};
+    WriteRecord(output, kPeriodType, period, sizeof(period));
+
+    // Oldest first, from after the newest entry.
+    uint16_t slot = next_slot_;
+
+    Entry   entries[kDumpEntries];
+    uint8_t count = 0;
+    for (uint16_t i = 0; i < slots_; ++i) {
+        Entry entry = ReadEntry(slot);
+        if (entry.sequence != kErased) {
+            entries[count++] = entry;
+        }
+        if (count == kDumpEntries || (i + 1 == slots_ && count > 0)) {
+            WriteRecord(output, kEntriesType, reinterpret_cast<const uint8_t *>(entries), count * sizeof(Entry));
+            count = 0;
+        }
+        if (++slot == slots_) {
+            slot = 0;
+        }
+    }
+}
+
+DischargeLog::Entry DischargeLog::ReadEntry(const uint16_t slot) {
+    Entry entry;
+    for (uint8_t i = 0; i < sizeof(Entry); ++i) {
+        reinterpret_cast<uint8_t *>(&entry)[i] = EEPROM.read(slot * sizeof(Entry) + i);
+    }
+    return entry;
+}
+
+// Erases the slot's sequence number, writes the other bytes, then the sequence
+// number, the first byte of the entry.
+void DischargeLog::WritePendingByte(void) {
+    uint16_t address = next_slot_ * sizeof(Entry);
+    if (pending_bytes_ == sizeof(Entry) + 1) {
+        EEPROM.update(address, kErased);
+    } else {
+        uint8_t offset = pending_bytes_ == 1 ? 0 : sizeof(Entry) - pending_bytes_ + 1;
+        EEPROM.update(address + offset, reinterpret_cast<const uint8_t *>(&pending_)[offset]);
+    }
+
+    if (--pending_bytes_ > 0) {
+        return;
+    }
+
+    LOG_VERBOSE("Discharge log entry %d written to slot %d\n", pending_.sequence, next_slot_);
+
+    if (++next_slot_ == slots_) {
+        next_slot_ = 0;
+    }
+    next_sequence_ = Next(next_sequence_);
+}
+
+void DischargeLog::WriteRecord(Print * output, const uint8_t type, const uint8_t * payload, const uint8_t size) {
+    uint8_t checksum = type ^ size;
+    for (uint8_t i = 0; i < size; ++i) {
+        checksum ^= payload[i];
+    }
+
+    output->write(kSync);
+    output->write(type);
+    output->write(size);
+    output->write(payload, size);
+    output->write(checksum);
+}
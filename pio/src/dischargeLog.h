@@ -0,0 +1,85 @@
+#pragma once
+
+// Logs Vcc with the state and brightness in use to a ring buffer in EEPROM,
+// for `tools/discharge_log.py` to fit a discharge model to.
+//
+// Each entry covers `DISCHARGE_LOG_PERIOD_S` of on-time (the clock stops
+// while powered down) and is 4 bytes:
+//
+//   sequence number (0 to 254, 0xFF is erased), the state the period was
+//   mostly spent in, the mean brightness, and Vcc at the end of the period
+//   as (mV - 2000) / 10
+//
+// The slot's sequence number is erased first and written last, so an entry
+// cut short by a power loss reads as erased. Entries run in slot order, each
+// carrying the sequence number after its predecessor's, from the oldest to
+// the newest.
+//
+// `Dump()` writes the log, when the host sends `kDumpCommand`, framed like the
+// sensor trace records (see `sensorTrace.h`):
+//
+//   'P' period:  `DISCHARGE_LOG_PERIOD_S` (uint16, little-endian)
+//   'D' entries: up to `kDumpEntries` entries, oldest first
+
+#include <stdint.h>
+
+#include <Arduino.h>
+
+#include "configuration.h"
+#include "stecchino.h"
+
+class DischargeLog {
+  public:
+    static const uint8_t kSync        = 0xD7;
+    static const uint8_t kPeriodType  = 'P';
+    static const uint8_t kEntriesType = 'D';
+    static const uint8_t kDumpEntries = 16;
+    static const uint8_t kDumpCommand = 'd';
+
+    DischargeLog(void);
+
+    // Finds where the log continues.
+    void Setup(void);
+
+    // Every `BATTERY_REFRESH_MS`: samples what is in use, and writes one
+    // byte of the pending entry so EEPROM writes never block.
+    void Sample(const Stecchino::State state, const uint8_t brightness, const int millivolts);
+
+    void Dump(Print * output) const;
+
+  private:
+    struct Entry {
+        uint8_t sequence;
+        uint8_t state;
+        uint8_t brightness;
+        uint8_t vcc;
+    };
+
+    static const uint8_t  kErased          = 0xFF;
+    static const uint8_t  kSequences       = 255;
+    static const uint16_t kSamplesPerEntry = 1000UL * DISCHARGE_LOG_PERIOD_S / BATTERY_REFRESH_MS;
+
+    uint16_t slots_;
+    uint16_t next_slot_;
+    uint8_t  next_sequence_;
+
+    // The period so far.
+    uint16_t state_samples_[Stecchino::kStateCount];
+    uint16_t samples_;
+    uint32_t brightness_sum_;
+
+    // Writes left for `pending_`: erasing the sequence number, the other
+    // bytes, then the sequence number.
+    Entry   pending_;
+    uint8_t pending_bytes_;
+
+    static Entry ReadEntry(const uint16_t slot);
+
+    static uint8_t Next(const uint8_t sequence) { return sequence + 1 == kSequences ? 0 : sequence + 1; }
+
+    static uint8_t Previous(const uint8_t sequence) { return sequence == 0 ? kSequences - 1 : sequence - 1; }
+
+    void WritePendingByte(void);
+
+    static void WriteRecord(Print * output, const uint8_t type, const uint8_t * payload, const uint8_t size);
+};
@@ -0,0 +1,91 @@
+#include "dutyCycle.h"
+
+#include <Arduino.h>
+#include <avr/pgmspace.h>
+#include <avr/sleep.h>
+
+#include "configuration.h"
+#include "logging.h"
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_DUTY_CYCLE
+
+namespace {
+
+const char kUnknownName[] PROGMEM             = "Unknown";
+const char kCheckBatteryName[] PROGMEM        = "CheckBattery";
+const char kFakeSleepName[] PROGMEM           = "FakeSleep";
+const char kGameOverTransitionName[] PROGMEM  = "GameOverTransition";
+const char kIdleName[] PROGMEM                = "Idle";
+const char kPlayName[] PROGMEM                = "Play";
+const char kSleepTransitionName[] PROGMEM     = "SleepTransition";
+const char kSpiritLevelName[] PROGMEM         = "SpiritLevel";
+const char kStartPlayTransitionName[] PROGMEM = "StartPlayTransition";
+
+// In `Stecchino::State` order.
+const char * const kStateNames[] PROGMEM = {
+    kUnknownName,
+    kCheckBatteryName,
+    kFakeSleepName,
+    kGameOverTransitionName,
+    kIdleName,
+    kPlayName,
+    kSleepTransitionName,
+    kSpiritLevelName,
+    kStartPlayTransitionName,
+};
+
+static_assert(sizeof(kStateNames) / sizeof(kStateNames[0]) == Stecchino::kStateCount, "A state has no name");
+
+}  // namespace
+
+DutyCycle::DutyCycle(void) : awake_(), asleep_(), last_wake_us_(micros()) {}
+
+void DutyCycle::Idle(const Stecchino::State state) {
+    unsigned long sleep_us = micros();
+
+#if IDLE_SLEEP
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sleep_mode();
+
+    unsigned long wake_us = micros();
+#else
+    unsigned long wake_us = sleep_us;
+#endif
+
+    Add(&awake_[static_cast<uint8_t>(state)], sleep_us - last_wake_us_);
+    Add(&asleep_[static_cast<uint8_t>(state)], wake_us - sleep_us);
+    last_wake_us_ = wake_us;
+}
+
+void DutyCycle::Restart(void) {
+    last_wake_us_ = micros();
+}
+
+void DutyCycle::LogReport(void) const {
+    for (uint8_t i = 0; i < kStates; ++i) {
+        // Not a state the stick has been in, e.g. Unknown, which Behavior
+        // leaves as it's set up.
+        unsigned long total_ms = awake_[i].ms + asleep_[i].ms;
+        if (total_ms == 0) {
+            continue;
+        }
+
+        int per_mille;
+        if (total_ms < 4000000UL) {
+            per_mille = static_cast<int>(1000UL * awake_[i].ms / total_ms);
+        } else {
+            // Past ~66 minutes, 1000 × awake would overflow.
+            per_mille = static_cast<int>(awake_[i].ms / (total_ms / 1000));
+        }
+
+        const __FlashStringHelper * name =
+            reinterpret_cast<const __FlashStringHelper *>(pgm_read_ptr(&kStateNames[i]));
+        LOG_NOTICE("Awake per mille in %S: %d\n", name, per_mille);
+    }
+}
+
+void DutyCycle::Add(Duration * duration, unsigned long us) {
+    us += duration->us;
+    duration->ms += us / 1000;
+    duration->us = static_cast<uint16_t>(us % 1000);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "stecchino.h"
+
+// Idles the CPU when `loop()` has nothing to run, and keeps for each Behavior
+// state how long the CPU was awake and asleep in it.
+//
+// The CPU sleeps in `SLEEP_MODE_IDLE` until the next interrupt: at the latest
+// the Timer0 overflow every 1.4 ms, sooner the MPU data-ready pulse or
+// Serial. The deeper modes would stop Timer0, and with it `millis()`,
+// `micros()` and the scheduler.
+class DutyCycle {
+  public:
+    static const uint8_t kStates = Stecchino::kStateCount;
+
+    DutyCycle(void);
+
+    // Nothing to run until the next interrupt: sleep, if `IDLE_SLEEP`, and
+    // count the time since the last call as awake in `state`.
+    void Idle(const Stecchino::State state);
+
+    // The CPU was powered down and the clock may have jumped, don't count the
+    // time since the last `Idle()`.
+    void Restart(void);
+
+    unsigned long GetAwakeMillis(const Stecchino::State state) const { return Get(awake_, state); }
+
+    unsigned long GetAsleepMillis(const Stecchino::State state) const { return Get(asleep_, state); }
+
+    // Logs the per mille of time awake in each state since boot, by name, for
+    // the states with any time in them.
+    void LogReport(void) const;
+
+  private:
+    struct Duration {
+        unsigned long ms;
+        uint16_t      us;
+    };
+
+    Duration awake_[kStates];
+    Duration asleep_[kStates];
+
+    unsigned long last_wake_us_;
+
+    static void Add(Duration * duration, unsigned long us);
+
+    static unsigned long Get(const Duration (&durations)[kStates], const Stecchino::State state) {
+        return durations[static_cast<uint8_t>(state)].ms;
+    }
+};
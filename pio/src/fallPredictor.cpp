@@ -0,0 +1,65 @@
+#include "fallPredictor.h"
+
+FallPredictor::FallPredictor(void) { Clear(); }
+
+void FallPredictor::Clear(void) {
+    count_      = 0;
+    newest_     = kHistory - 1;
+    confidence_ = 0;
+    rate_       = 0;
+}
+
+void FallPredictor::Add(const uint16_t ms, const int16_t tilt) {
+    if (count_ > 0 && static_cast<uint16_t>(ms - times_[newest_]) > kMaxGapMs) {
+        Clear();
+    }
+
+    newest_         = (newest_ + 1) % kHistory;
+    times_[newest_] = ms;
+    tilts_[newest_] = tilt;
+    if (count_ < kHistory) {
+        ++count_;
+    }
+
+    Predict();
+}
+
+void FallPredictor::Predict(void) {
+    confidence_ = 0;
+    rate_       = 0;
+
+    if (count_ < kHistory) {
+        return;
+    }
+
+    uint8_t  oldest  = (newest_ + 1) % kHistory;
+    uint16_t span_ms = times_[newest_] - times_[oldest];
+    if (span_ms == 0) {
+        return;
+    }
+
+    int16_t tilt = tilts_[newest_];
+    int32_t rise = static_cast<int32_t>(tilt) - tilts_[oldest];
+    rate_        = static_cast<int16_t>(rise * 10 / span_ms);
+
+    if (tilt < FALL_PREDICTION_MIN_TILT || rise <= 0) {
+        return;
+    }
+
+    int32_t margin = tilt + rise * FALL_PREDICTION_HORIZON_MS / span_ms - kFallenTilt;
+    if (margin <= 0) {
+        return;
+    }
+
+    // Scaled by the share of the updates the lean grew over.
+    uint8_t rising = 0;
+    for (uint8_t i = 1; i < kHistory; ++i) {
+        uint8_t index = (oldest + i) % kHistory;
+        if (tilts_[index] > tilts_[(index + kHistory - 1) % kHistory]) {
+            ++rising;
+        }
+    }
+
+    int32_t confidence = margin >= kFullConfidenceMargin ? 255 : margin * 255 / kFullConfidenceMargin;
+    confidence_        = static_cast<uint8_t>(confidence * rising / (kHistory - 1));
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "configuration.h"
+
+// Calls a fall before the stick passes 45°, from how far it leans and how
+// fast the lean grows.
+//
+// The tilt from vertical is projected FALL_PREDICTION_HORIZON_MS ahead at its
+// rate over the last few updates. Past 45° the fall is likely beyond
+// recovery, the more so the further past and the steadier the lean has grown:
+// a player catching the stick slows it within a couple of updates. Leans
+// under FALL_PREDICTION_MIN_TILT are balancing and never count.
+//
+// The rate comes from the tilt history rather than the gyro, so it works with
+// every Position mode and on replayed traces, which hold no gyro.
+class FallPredictor {
+  public:
+    FallPredictor(void);
+
+    void Clear(void);
+
+    // Add the tilt from vertical at `ms`, in hundredths of a degree.
+    void Add(const uint16_t ms, const int16_t tilt);
+
+    // From 0, no sign of a fall, to 255.
+    uint8_t GetConfidence(void) const { return confidence_; }
+
+    // Of the tilt over the history, in whole degrees per second.
+    int16_t GetRate(void) const { return rate_; }
+
+  private:
+    static const uint8_t kHistory = 5;
+
+    // A longer gap, e.g. sampling stopped, starts the history over.
+    static const uint16_t kMaxGapMs = 200;
+
+    static const int16_t kFallenTilt = 4500;
+
+    // How far past 45° the projection must be for full confidence.
+    static const int16_t kFullConfidenceMargin = 1500;
+
+    uint16_t times_[kHistory];
+    int16_t  tilts_[kHistory];
+    uint8_t  count_;
+    uint8_t  newest_;
+
+    uint8_t confidence_;
+    int16_t rate_;
+
+    void Predict(void);
+};
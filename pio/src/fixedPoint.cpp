@@ -0,0 +1,54 @@
+#include "fixedPoint.h"
+
+#include <avr/pgmspace.h>
+
+namespace {
+
+// Ratios of the smaller to the larger coordinate, in Q14, index the table by
+// their top 5 bits and interpolate with the rest.
+const uint8_t  kRatioBits    = 14;
+const uint8_t  kFractionBits = kRatioBits - 5;
+const uint16_t kFractionMask = (1U << kFractionBits) - 1;
+
+// `atan(i / 32)` in hundredths of a degree.
+const uint16_t kAtanTable[] PROGMEM = {
+    0,    179,  358,  536,  713,  888,  1062, 1234, 1404, 1571, 1735, 1897, 2056, 2211, 2363, 2511, 2657,
+    2798, 2936, 3070, 3201, 3327, 3451, 3571, 3687, 3800, 3909, 4016, 4119, 4218, 4315, 4409, 4500,
+};
+
+const int16_t kRightAngle    = 9000;
+const int16_t kStraightAngle = 18000;
+
+}  // namespace
+
+int16_t Atan2CentiDegrees(const int16_t y, const int16_t x) {
+    uint16_t abs_x = Magnitude(x);
+    uint16_t abs_y = Magnitude(y);
+    if (abs_x == 0 && abs_y == 0) {
+        return 0;
+    }
+
+    // Fold into the first octant so the ratio is within [0, 1].
+    bool     steep = abs_y > abs_x;
+    uint16_t small = steep ? abs_x : abs_y;
+    uint16_t large = steep ? abs_y : abs_x;
+
+    uint16_t ratio    = static_cast<uint16_t>((static_cast<uint32_t>(small) << kRatioBits) / large);
+    uint8_t  index    = static_cast<uint8_t>(ratio >> kFractionBits);
+    uint16_t fraction = ratio & kFractionMask;
+
+    int16_t angle = static_cast<int16_t>(pgm_read_word(&kAtanTable[index]));
+    if (fraction != 0) {
+        uint16_t step = pgm_read_word(&kAtanTable[index + 1]) - static_cast<uint16_t>(angle);
+        angle += static_cast<int16_t>(
+            (static_cast<uint32_t>(step) * fraction + (1U << (kFractionBits - 1))) >> kFractionBits);
+    }
+
+    if (steep) {
+        angle = kRightAngle - angle;
+    }
+    if (x < 0) {
+        angle = kStraightAngle - angle;
+    }
+    return y < 0 ? -angle : angle;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stdint.h>
+
+// Integer replacements for the float math in the sensor pipeline, which the
+// ATmega328 can only emulate in software.
+
+// Absolute value, without the overflow of `abs(-32768)`.
+inline uint16_t Magnitude(const int16_t value) {
+    return value < 0 ? static_cast<uint16_t>(0U - static_cast<uint16_t>(value)) : static_cast<uint16_t>(value);
+}
+
+// `atan2(y, x)` in hundredths of a degree, from -18000 to 18000, within
+// 0.02° of the float result. `(0, 0)` gives 0.
+int16_t Atan2CentiDegrees(const int16_t y, const int16_t x);
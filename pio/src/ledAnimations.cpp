@@ -0,0 +1,41 @@
+// Generated by tools/led_animations.py from tools/led_animations.txt, do not edit.
+
+#include "ledAnimations.h"
+
+#include <avr/pgmspace.h>
+
+#include "configuration.h"
+
+#if NUM_LEDS != 72
+#    error "NUM_LEDS changed, rerun tools/led_animations.py"
+#endif
+
+// 14 bytes.
+const uint8_t kBatteryLevelAnimation[] PROGMEM = {
+    1,
+    6, 0xFF, 0x00, 0x00,
+    10, 0xFF, 0xA5, 0x00,
+    56, 0x00, 0x80, 0x00,
+    0,
+};
+
+// 6 bytes.
+const uint8_t kGameOverAnimation[] PROGMEM = {
+    1,
+    72, 0xFF, 0x00, 0x00,
+    0,
+};
+
+// 6 bytes.
+const uint8_t kGoingToSleepAnimation[] PROGMEM = {
+    1,
+    72, 0x00, 0x00, 0xFF,
+    0,
+};
+
+// 6 bytes.
+const uint8_t kStartPlayAnimation[] PROGMEM = {
+    1,
+    72, 0x00, 0x80, 0x00,
+    0,
+};
@@ -0,0 +1,19 @@
+#pragma once
+
+// LED animations stored in flash, generated by `tools/led_animations.py`
+// from `tools/led_animations.txt`, for `LedStrip::DrawFrame()` to decode
+// straight into the strip.
+//
+// An animation is its frame count, then each frame in turn as runs from the
+// first LED on:
+//
+//   count (1 to 255), red, green, blue
+//
+// ended by a 0 count. LEDs past a frame's last run are black.
+
+#include <stdint.h>
+
+extern const uint8_t kBatteryLevelAnimation[];
+extern const uint8_t kGameOverAnimation[];
+extern const uint8_t kGoingToSleepAnimation[];
+extern const uint8_t kStartPlayAnimation[];
@@ -1,56 +1,222 @@
 #include "ledStrip.h"
 
 #include <Arduino.h>
-#include <ArduinoLog.h>
 #include <FastLED.h>
+#include <avr/pgmspace.h>
+#include <string.h>
 
 #include "configuration.h"
+#include "ledAnimations.h"
+#include "logging.h"
 
-LedStrip::LedStrip() : frame_count_(0), hue_(0), led_count_(NUM_LEDS) {}
+#define LOG_MODULE_LEVEL LOG_LEVEL_LED_STRIP
+
+namespace {
+
+// What each pixel draws even when black, power_mgt's `gDark_mW`.
+const uint8_t kDarkMilliwatts = 5;
+
+// power_mgt's figures are for 5V.
+const uint8_t kMilliwattsPerMilliamp = 5;
+
+}  // namespace
+
+LedStrip::LedStrip()
+    : frame_count_(0),
+      hue_(0),
+      wiping_off_(false),
+      wipe_start_time_(0),
+      frame_shown_(false),
+      shown_brightness_(0),
+      power_budget_mw_(kMilliwattsPerMilliamp * LED_BUDGET_MAX_VCC_MA),
+      led_count_(NUM_LEDS),
+      controller_(nullptr) {
+    memset(shown_signatures_, 0, sizeof(shown_signatures_));
+    memset(block_power_mw_, 0, sizeof(block_power_mw_));
+}
 
 // Setup LED strip.
 void LedStrip::Setup(void) {
     pinMode(PIN_MOSFET_GATE, OUTPUT);
     digitalWrite(PIN_MOSFET_GATE, HIGH);
 
-    FastLED.addLeds<WS2812B, PIN_LED_DATA, GRB>(leds_, static_cast<int>(led_count_));
+    controller_ = &FastLED.addLeds<WS2812B, PIN_LED_DATA, GRB>(leds_, static_cast<int>(led_count_));
     FastLED.setBrightness(LOW_BRIGHTNESS);
 }
 
 void LedStrip::Update(void) {
-    Log.trace(F("LedStrip::Update\n"));
+    LOG_TRACE("LedStrip::Update\n");
 
     // Slowly cycle the "base color" through the rainbow.
     EVERY_N_MILLISECONDS(20) { ++hue_; }
 
-    FastLED.show();
+    if (wiping_off_) {
+        WipeOffStep();
+    }
+
+    // A full show takes ~2.2 ms with interrupts off, and most states redraw
+    // the same frame until something happens.
+    uint8_t dirty_blocks = 0;
+    for (uint8_t block = 0; block < kBlocks; ++block) {
+        uint32_t signature = BlockSignature(block);
+        // A black block matches the zeroed signature of a strip not shown
+        // yet, its power still needs counting.
+        if (signature != shown_signatures_[block] || !frame_shown_) {
+            shown_signatures_[block] = signature;
+            block_power_mw_[block]   = BlockPower(block);
+            dirty_blocks             = block + 1;
+        }
+    }
+
+    // A new brightness rescales every pixel, stream the whole strip.
+    uint8_t brightness = FastLED.getBrightness();
+#if LED_POWER_BUDGET
+    brightness = CapBrightness(brightness);
+#endif
+    if (!frame_shown_ || brightness != shown_brightness_) {
+        dirty_blocks = kBlocks;
+    }
+
+    if (dirty_blocks == 0) {
+        return;
+    }
+
+    controller_->setLeds(leds_, min(dirty_blocks * kBlockLeds, static_cast<int>(led_count_)));
+    FastLED.show(brightness);
+
+    frame_shown_      = true;
+    shown_brightness_ = brightness;
+}
+
+// Fletcher-style sums of the block's pixel bytes, which catch changed and
+// moved pixels alike at a fraction of the cost of a show. They are kept to 16
+// bits so they don't wrap over a block, 8 bit sums miss e.g. a block of
+// `CRGB::Green` turning black.
+uint32_t LedStrip::BlockSignature(const uint8_t block) const {
+    uint8_t first = block * kBlockLeds;
+    uint8_t last  = min(first + kBlockLeds, static_cast<int>(led_count_));
+
+    const uint8_t * bytes       = reinterpret_cast<const uint8_t *>(&leds_[first]);
+    uint16_t        sum         = 0;
+    uint16_t        sum_of_sums = 0;
+    for (uint8_t i = 0; i < (last - first) * sizeof(CRGB); ++i) {
+        sum += bytes[i];
+        sum_of_sums += sum;
+    }
+    return (static_cast<uint32_t>(sum_of_sums) << 16) | sum;
+}
+
+uint16_t LedStrip::BlockPower(const uint8_t block) const {
+    uint8_t first = block * kBlockLeds;
+    uint8_t last  = min(first + kBlockLeds, static_cast<int>(led_count_));
+
+    return static_cast<uint16_t>(calculate_unscaled_power_mW(&leds_[first], last - first));
+}
+
+void LedStrip::SetSupplyMillivolts(const int millivolts) {
+    long budget_ma = map(constrain(millivolts, MIN_VCC_MV, MAX_VCC_MV),
+                         MIN_VCC_MV,
+                         MAX_VCC_MV,
+                         LED_BUDGET_MIN_VCC_MA,
+                         LED_BUDGET_MAX_VCC_MA);
+
+    power_budget_mw_ = static_cast<uint16_t>(kMilliwattsPerMilliamp * budget_ma);
+}
+
+// Dims `brightness` as far as needed to keep the frame within the power
+// budget, as power_mgt's `calculate_max_brightness_for_power_mW()` does but
+// from the blocks' cached power and with the dark current left unscaled.
+uint8_t LedStrip::CapBrightness(const uint8_t brightness) const {
+    uint16_t unscaled_mw = 0;
+    for (uint8_t block = 0; block < kBlocks; ++block) {
+        unscaled_mw += block_power_mw_[block];
+    }
+
+    uint16_t dark_mw = kDarkMilliwatts * led_count_;
+    if (power_budget_mw_ <= dark_mw) {
+        return 0;
+    }
+    if (unscaled_mw <= dark_mw) {
+        return brightness;
+    }
+
+    // `scale8()` scales by `brightness + 1`.
+    uint16_t color_mw   = unscaled_mw - dark_mw;
+    uint32_t allowed_mw = static_cast<uint32_t>(power_budget_mw_ - dark_mw) << 8;
+    if (static_cast<uint32_t>(color_mw) * (brightness + 1) <= allowed_mw) {
+        return brightness;
+    }
+
+    uint32_t capped = allowed_mw / color_mw;
+    return capped > 0 ? static_cast<uint8_t>(capped - 1) : 0;
+}
+
+// Decode `frame` of a flash animation from `ledAnimations.h` into the strip,
+// up to the `lit` first LEDs, the rest black.
+void LedStrip::DrawFrame(const uint8_t * animation, const uint8_t frame, const uint8_t lit) {
+    const uint8_t * runs = animation + 1;
+    for (uint8_t skip = frame % pgm_read_byte(animation); skip > 0; --skip) {
+        while (pgm_read_byte(runs) != 0) {
+            runs += 4;
+        }
+        ++runs;
+    }
+
+    uint8_t end = min(lit, led_count_);
+    uint8_t led = 0;
+    for (uint8_t count = pgm_read_byte(runs); count != 0 && led < end; runs += 4, count = pgm_read_byte(runs)) {
+        uint8_t filled = min(count, static_cast<uint8_t>(end - led));
+        CRGB    color(pgm_read_byte(runs + 1), pgm_read_byte(runs + 2), pgm_read_byte(runs + 3));
+        fill_solid(&leds_[led], filled, color);
+        led += filled;
+    }
+    fill_solid(&leds_[led], led_count_ - led, CRGB::Black);
 }
 
 void LedStrip::Off(void) {
-    Log.trace(F("LedStrip::Off\n"));
+    LOG_TRACE("LedStrip::Off\n");
 
-    for (int i = 0; i < led_count_; ++i) {
-        leds_[i] = CRGB::Black;
+    // Callers may keep asking for Off while the wipe runs, don't restart it.
+    if (wiping_off_) {
+        return;
+    }
+
+    wiping_off_      = true;
+    wipe_start_time_ = millis();
+}
+
+// Blank the LEDs the wipe has reached by now, so the wipe takes the same time
+// however often `Update()` is called.
+void LedStrip::WipeOffStep(void) {
+    unsigned long wiped = (millis() - wipe_start_time_) / OFF_WIPE_MS_PER_LED + 1;
 
-        // leds_[i].nscale8(230);
-        delay(10);
-        FastLED.show();
+    if (wiped >= static_cast<unsigned long>(led_count_)) {
+        wiped       = led_count_;
+        wiping_off_ = false;
     }
+
+    for (unsigned long i = 0; i < wiped; ++i) {
+        leds_[i] = CRGB::Black;
+    }
+}
+
+// The next state started drawing, let it have the strip.
+void LedStrip::CancelOff(void) {
+    wiping_off_ = false;
 }
 
 void LedStrip::On(const int count, const int record) {
-    Log.trace(F("LedStrip::On\n"));
+    LOG_TRACE("LedStrip::On\n");
 
-    for (int i = 0; i < led_count_; ++i) {
-        if (i <= led_count_ - count) {
-            leds_[i] = CRGB::Black;
-        } else {
-            leds_[i] = CHSV(hue_, 255, 255);
-        }
+    CancelOff();
 
-        if (i == led_count_ - record) {
-            leds_[i] = CRGB::Red;
-        }
+    // Lit from the far end, in one color converted once rather than per pixel.
+    int dark = constrain(led_count_ - count + 1, 0, static_cast<int>(led_count_));
+    fill_solid(leds_, dark, CRGB::Black);
+    fill_solid(&leds_[dark], led_count_ - dark, CHSV(hue_, 255, 255));
+
+    if (record >= 1 && record <= led_count_) {
+        leds_[led_count_ - record] = CRGB::Red;
     }
 }
 
@@ -71,33 +237,23 @@ void LedStrip::CylonPattern() {
 }
 
 void LedStrip::ShowBatteryLevel(const int millivolts) {
-    Log.trace(F("LedStrip::ShowBatteryLevel\n"));
+    LOG_TRACE("LedStrip::ShowBatteryLevel\n");
+
+    CancelOff();
 
     int pos_led = map(millivolts, MIN_VCC_MV, MAX_VCC_MV, 1, led_count_);
 
-    Log.verbose(F("Showing battery level at LED Position: %d\n"), pos_led);
+    LOG_VERBOSE("Showing battery level at LED Position: %d\n", pos_led);
 
-    for (int i = 0; i < led_count_; ++i) {
-        if (i <= pos_led) {
-            if (i <= 5) {
-                leds_[i] = CRGB::Red;
-            } else if (i > 5 && i <= 15) {
-                leds_[i] = CRGB::Orange;
-            } else {
-                leds_[i] = CRGB::Green;
-            }
-        } else {
-            leds_[i] = CRGB::Black;
-        }
-    }
+    DrawFrame(kBatteryLevelAnimation, 0, constrain(pos_led + 1, 0, static_cast<int>(led_count_)));
 }
 
-void LedStrip::ShowSpiritLevel(const float angle) {
-    Log.trace(F("LedStrip::ShowSpiritLevel\n"));
+void LedStrip::ShowSpiritLevel(const int16_t angle) {
+    LOG_TRACE("LedStrip::ShowSpiritLevel\n");
 
-    int int_angle = static_cast<int>(angle);
+    CancelOff();
 
-    int position = map(int_angle, -45, 45, 1, led_count_);
+    int position = map(angle, -45, 45, 1, led_count_);
     int color    = map(position, 0, led_count_, 0, 255);
 
     for (int i = 0; i < led_count_; ++i) {
@@ -110,21 +266,25 @@ void LedStrip::ShowSpiritLevel(const float angle) {
 }
 
 void LedStrip::ShowIdle() {
-    Log.trace(F("LedStrip::ShowIdle\n"));
+    LOG_TRACE("LedStrip::ShowIdle\n");
+
+    CancelOff();
 
     ConfettiPattern();
 }
 
 void LedStrip::ShowStartPlay() {
-    Log.trace(F("LedStrip::ShowStartPlay()\n"));
+    LOG_TRACE("LedStrip::ShowStartPlay()\n");
 
-    for (int i = 0; i < led_count_; ++i) {
-        leds_[i] = CRGB::Green;
-    }
+    CancelOff();
+
+    DrawFrame(kStartPlayAnimation, 0, led_count_);
 }
 
 void LedStrip::ShowWinner() {
-    Log.trace(F("LedStrip::ShowWinner()\n"));
+    LOG_TRACE("LedStrip::ShowWinner()\n");
+
+    CancelOff();
 
     frame_count_ += 1;
 
@@ -136,32 +296,29 @@ void LedStrip::ShowWinner() {
 }
 
 void LedStrip::ShowGoingToSleep() {
-    Log.trace(F("LedStrip::ShowGoingToSleep()\n"));
+    LOG_TRACE("LedStrip::ShowGoingToSleep()\n");
 
-    for (int i = 0; i < led_count_; ++i) {
-        leds_[i] = CRGB::Blue;
-    }
+    CancelOff();
+
+    DrawFrame(kGoingToSleepAnimation, 0, led_count_);
 }
 
 void LedStrip::ShowPattern(const LedStrip::Pattern pattern) {
-    Log.trace(F("LedStrip::ShowPattern\n"));
+    LOG_TRACE("LedStrip::ShowPattern\n");
+
+    CancelOff();
 
     switch (pattern) {
         case LedStrip::Pattern::kSpiritLevel: {
-            Log.verbose(F("Pattern: SPIRIT_LEVEL\n"));
+            LOG_VERBOSE("Pattern: SPIRIT_LEVEL\n");
 
             CylonPattern();
         } break;
 
         case LedStrip::Pattern::kGameOver: {
-            Log.verbose(F("Pattern: GAME_OVER\n"));
+            LOG_VERBOSE("Pattern: GAME_OVER\n");
 
-            for (int i = 0; i < led_count_; ++i) {
-                leds_[i] = CRGB::Red;
-            }
+            DrawFrame(kGameOverAnimation, 0, led_count_);
         } break;
     }
-
-    FastLED.show();
-    delay(1000 / FRAMES_PER_SECOND);
 }
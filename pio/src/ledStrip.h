@@ -19,15 +19,29 @@ class LedStrip {
 
     void Setup(void);
 
+    // Push the frame to the strip, up to the last LED that changed since the
+    // last push.
     void Update(void);
 
+    // The strip lost power and its pixels, push the next frame even if unchanged.
+    void Invalidate(void) { frame_shown_ = false; }
+
+    // Brightness of the frame on the strip.
+    uint8_t GetBrightness(void) const { return shown_brightness_; }
+
+    // Scale the strip's power budget to the supply, from LED_BUDGET_MAX_VCC_MA
+    // at MAX_VCC_MV down to LED_BUDGET_MIN_VCC_MA at MIN_VCC_MV.
+    void SetSupplyMillivolts(const int millivolts);
+
+    // Start wiping the strip to black, one step per `Update()`. Any of the
+    // drawing methods below cancels the wipe.
     void Off(void);
 
     void On(const int count, const int record);
 
     void ShowBatteryLevel(const int millivolts);
 
-    void ShowSpiritLevel(const float angle);
+    void ShowSpiritLevel(const int16_t angle);
 
     void ShowIdle();
 
@@ -45,10 +59,46 @@ class LedStrip {
 
     uint8_t hue_;
 
+    // Turn-off wipe in progress, and when it started.
+    bool          wiping_off_;
+    unsigned long wipe_start_time_;
+
+    // WS2812 pixels latch the first 24 bits they receive and pass the rest
+    // down the strip, so a shorter stream updates only a prefix of the strip
+    // and the rest keeps its colors. Frames are compared in blocks of LEDs to
+    // stream only up to the last block that changed.
+    static const uint8_t kBlockLeds = 12;
+    static const uint8_t kBlocks    = (NUM_LEDS + kBlockLeds - 1) / kBlockLeds;
+
+    // What the strip shows, to skip pushing unchanged pixels.
+    bool     frame_shown_;
+    uint32_t shown_signatures_[kBlocks];
+    uint8_t  shown_brightness_;
+
+    // Unscaled power of each block as shown, in the mW at 5V of FastLED's
+    // power_mgt, updated with its signature so a frame's estimate only costs
+    // the blocks that changed.
+    uint16_t block_power_mw_[kBlocks];
+    uint16_t power_budget_mw_;
+
     const uint8_t led_count_;
 
     CRGB leds_[NUM_LEDS];
 
+    CLEDController * controller_;
+
+    uint32_t BlockSignature(const uint8_t block) const;
+
+    uint16_t BlockPower(const uint8_t block) const;
+
+    uint8_t CapBrightness(const uint8_t brightness) const;
+
+    void DrawFrame(const uint8_t * animation, const uint8_t frame, const uint8_t lit);
+
+    void WipeOffStep(void);
+
+    void CancelOff(void);
+
     void ConfettiPattern(void);
 
     void CylonPattern(void);
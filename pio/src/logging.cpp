@@ -0,0 +1,40 @@
+#include "logging.h"
+
+#include <string.h>
+
+BinaryLogging BinaryLog;
+
+void BinaryLogging::WriteHeader(const uint16_t id) {
+    output_->write(kSync);
+    output_->write(static_cast<uint8_t>(id & 0xFF));
+    output_->write(static_cast<uint8_t>(id >> 8));
+}
+
+void BinaryLogging::WriteArg(const float value) {
+    uint8_t bytes[sizeof(float)];
+    memcpy(bytes, &value, sizeof(bytes));
+    output_->write(bytes, sizeof(bytes));
+}
+
+void BinaryLogging::WriteArg(const char * value) {
+    output_->write(reinterpret_cast<const uint8_t *>(value), strlen(value) + 1);
+}
+
+void BinaryLogging::WriteArg(const __FlashStringHelper * value) {
+    const char * p = reinterpret_cast<const char *>(value);
+    char         c;
+    do {
+        c = pgm_read_byte(p++);
+        output_->write(static_cast<uint8_t>(c));
+    } while (c != '\0');
+}
+
+// Small magnitudes of either sign take a single byte.
+void BinaryLogging::WriteVarint(const int32_t value) {
+    uint32_t zigzag = (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+    while (zigzag >= 0x80) {
+        output_->write(static_cast<uint8_t>(zigzag | 0x80));
+        zigzag >>= 7;
+    }
+    output_->write(static_cast<uint8_t>(zigzag));
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+// Logging macros with per-module, compile-time levels.
+//
+// Each source file picks its module's level from `configuration.h`, after
+// its includes:
+//
+//   #define LOG_MODULE_LEVEL LOG_LEVEL_POSITION
+//
+//   LOG_TRACE("Position::Update\n");
+//   LOG_NOTICE("Vertical: %F\n", vertical);
+//
+// Calls above the module's level compile to nothing, format string included.
+// The rest go to ArduinoLog as text or, with `LOG_BINARY`, to `BinaryLog` as
+// compact records that `tools/log_decode.py` turns back into the same text.
+
+#include <stdint.h>
+
+#include <Arduino.h>
+#include <ArduinoLog.h>
+
+#include "configuration.h"
+
+// FNV-1a of the format string, folded to 16 bits. `tools/log_decode.py` hashes
+// the format strings in the sources the same way to map IDs back to text.
+constexpr uint32_t LogHash(const char * format, uint32_t hash = 2166136261UL) {
+    return *format == '\0' ? hash : LogHash(format + 1, (hash ^ static_cast<uint8_t>(*format)) * 16777619UL);
+}
+
+constexpr uint16_t LogId(const char * format) {
+    return static_cast<uint16_t>(LogHash(format) ^ (LogHash(format) >> 16));
+}
+
+// Forces `LogId()` to be evaluated at compile time.
+template <uint16_t id>
+struct LogIdConstant {
+    static const uint16_t value = id;
+};
+
+// Binary log record:
+//
+//   0xA5, message ID (uint16, little-endian), then each argument in order:
+//   floats as 4 raw bytes (little-endian IEEE 754), strings NUL-terminated,
+//   everything else as a zigzag varint.
+class BinaryLogging {
+  public:
+    static const uint8_t kSync = 0xA5;
+
+    BinaryLogging(void) : output_(nullptr) {}
+
+    void begin(Print * output) { output_ = output; }
+
+    template <typename... Args>
+    void Write(const uint16_t id, Args... args) {
+        if (output_ == nullptr) {
+            return;
+        }
+        WriteHeader(id);
+        WriteArgs(args...);
+    }
+
+  private:
+    Print * output_;
+
+    void WriteHeader(const uint16_t id);
+
+    void WriteArgs(void) {}
+
+    template <typename T, typename... Args>
+    void WriteArgs(T arg, Args... args) {
+        WriteArg(arg);
+        WriteArgs(args...);
+    }
+
+    void WriteArg(const float value);
+    void WriteArg(const double value) { WriteArg(static_cast<float>(value)); }
+    void WriteArg(const char * value);
+    void WriteArg(const __FlashStringHelper * value);
+    void WriteArg(const bool value) { WriteVarint(value ? 1 : 0); }
+    void WriteArg(const char value) { WriteVarint(value); }
+    void WriteArg(const signed char value) { WriteVarint(value); }
+    void WriteArg(const unsigned char value) { WriteVarint(value); }
+    void WriteArg(const short value) { WriteVarint(value); }
+    void WriteArg(const unsigned short value) { WriteVarint(value); }
+    void WriteArg(const int value) { WriteVarint(value); }
+    void WriteArg(const unsigned int value) { WriteVarint(static_cast<int32_t>(value)); }
+    void WriteArg(const long value) { WriteVarint(static_cast<int32_t>(value)); }
+    void WriteArg(const unsigned long value) { WriteVarint(static_cast<int32_t>(value)); }
+
+    void WriteVarint(const int32_t value);
+};
+
+extern BinaryLogging BinaryLog;
+
+#if LOG_BINARY
+#    define LOG_AT(level, method, format, ...)                                       \
+        do {                                                                         \
+            if (LOG_MODULE_LEVEL >= (level)) {                                       \
+                BinaryLog.Write(LogIdConstant<LogId(format)>::value, ##__VA_ARGS__); \
+            }                                                                        \
+        } while (0)
+#else
+#    define LOG_AT(level, method, format, ...)        \
+        do {                                          \
+            if (LOG_MODULE_LEVEL >= (level)) {        \
+                Log.method(F(format), ##__VA_ARGS__); \
+            }                                         \
+        } while (0)
+#endif
+
+#define LOG_FATAL(format, ...) LOG_AT(LOG_LEVEL_FATAL, fatal, format, ##__VA_ARGS__)
+#define LOG_ERROR(format, ...) LOG_AT(LOG_LEVEL_ERROR, error, format, ##__VA_ARGS__)
+#define LOG_WARNING(format, ...) LOG_AT(LOG_LEVEL_WARNING, warning, format, ##__VA_ARGS__)
+#define LOG_NOTICE(format, ...) LOG_AT(LOG_LEVEL_NOTICE, notice, format, ##__VA_ARGS__)
+#define LOG_TRACE(format, ...) LOG_AT(LOG_LEVEL_TRACE, trace, format, ##__VA_ARGS__)
+#define LOG_VERBOSE(format, ...) LOG_AT(LOG_LEVEL_VERBOSE, verbose, format, ##__VA_ARGS__)
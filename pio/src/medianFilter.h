@@ -0,0 +1,92 @@
+#pragma once
+
+#include <stdint.h>
+
+// Running median over the last `kWindow` samples of `kChannels` channels that
+// are sampled together, e.g. the three accelerometer axes.
+//
+// Each channel keeps its window sorted: `Add()` replaces the oldest sample
+// with the new one in place, moving only the samples ranked between them, and
+// `GetMedian()` is a lookup. For a slowly changing signal the new sample
+// lands next to the old one, so an update costs a binary search and a few
+// moves instead of the copy and full sort `RunningMedian` does per median.
+//
+// As with `RunningMedian`, a partly filled window returns the upper median.
+template <typename T, uint8_t kChannels, uint8_t kWindow>
+class MedianFilter {
+  public:
+    MedianFilter(void) { Clear(); }
+
+    // Add one sample for each channel.
+    void Add(const T (&values)[kChannels]) {
+        for (uint8_t channel = 0; channel < kChannels; ++channel) {
+            T * sorted = sorted_[channel];
+            T   value  = values[channel];
+
+            uint8_t i;
+            if (count_ < kWindow) {
+                // Not full yet: insert into the sorted prefix.
+                i = count_;
+                while (i > 0 && sorted[i - 1] > value) {
+                    sorted[i] = sorted[i - 1];
+                    --i;
+                }
+            } else {
+                // Overwrite the oldest sample and move the new one into rank.
+                i = Find(sorted, history_[oldest_][channel]);
+                while (i + 1 < kWindow && sorted[i + 1] < value) {
+                    sorted[i] = sorted[i + 1];
+                    ++i;
+                }
+                while (i > 0 && sorted[i - 1] > value) {
+                    sorted[i] = sorted[i - 1];
+                    --i;
+                }
+            }
+            sorted[i] = value;
+
+            history_[oldest_][channel] = value;
+        }
+
+        if (++oldest_ == kWindow) {
+            oldest_ = 0;
+        }
+        if (count_ < kWindow) {
+            ++count_;
+        }
+    }
+
+    // Must not be called on an empty filter.
+    T GetMedian(const uint8_t channel) const { return sorted_[channel][count_ / 2]; }
+
+    uint8_t GetCount(void) const { return count_; }
+
+    void Clear(void) {
+        count_  = 0;
+        oldest_ = 0;
+    }
+
+  private:
+    // Samples in arrival order, `oldest_` is the next one overwritten.
+    T history_[kWindow][kChannels];
+
+    T sorted_[kChannels][kWindow];
+
+    uint8_t count_;
+    uint8_t oldest_;
+
+    // Index of a sample equal to `value` in the full, sorted window.
+    static uint8_t Find(const T * sorted, const T value) {
+        uint8_t low  = 0;
+        uint8_t high = kWindow - 1;
+        while (low < high) {
+            uint8_t middle = (low + high) / 2;
+            if (sorted[middle] < value) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        return low;
+    }
+};
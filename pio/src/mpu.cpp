@@ -1,15 +1,27 @@
 #include "mpu.h"
 
-#include <ArduinoLog.h>
 #include <MPU6050.h>
+#if POSITION_DMP
+// Defines the DMP image and driver, so only this file may include it.
+#    include <MPU6050_6Axis_MotionApps20.h>
+#endif
 
 #include "configuration.h"
+#include "logging.h"
 
-Mpu::Mpu(void){};
+#define LOG_MODULE_LEVEL LOG_LEVEL_MPU
+
+#if MPU_LOW_POWER && (POSITION_FUSION || POSITION_DMP)
+#    error "MPU_LOW_POWER puts the gyros in standby, which POSITION_FUSION and POSITION_DMP read"
+#endif
+
+volatile uint8_t Mpu::pending_samples_ = 0;
+
+Mpu::Mpu(void) : profile_(Profile::kFull){};
 
 // Setup MPU.
 bool Mpu::Setup(void) {
-    Log.trace(F("Mpu::Setup\n"));
+    LOG_TRACE("Mpu::Setup\n");
 
     pinMode(PIN_MPU_POWER, OUTPUT);
     digitalWrite(PIN_MPU_POWER, HIGH);
@@ -23,11 +35,28 @@ bool Mpu::Setup(void) {
     mpu_.initialize();
 
     if (!mpu_.testConnection()) {
-        Log.error(F("MPU6050 connection failed\n"));
+        LOG_ERROR("MPU6050 connection failed\n");
         return false;
     }
 
-    Log.notice(F("MPU6050 connection successful\n"));
+    LOG_NOTICE("MPU6050 connection successful\n");
+
+#if POSITION_DMP
+    // Resets the MPU, then loads and verifies the DMP image, leaving the DMP
+    // sampling at 200Hz through the 42Hz low-pass.
+    uint8_t dmp_status = mpu_.dmpInitialize();
+    if (dmp_status != 0) {
+        LOG_ERROR("MPU6050 DMP initialization failed: %d\n", dmp_status);
+        return false;
+    }
+
+    // D_0_22, the divider from the DMP's 200Hz to its FIFO rate.
+    const uint8_t dmp_fifo_rate[] = {0, 200 / POSITION_DMP_RATE_HZ - 1};
+    mpu_.writeMemoryBlock(dmp_fifo_rate, sizeof(dmp_fifo_rate), 0x02, 0x16);
+
+    // Only the interrupts counted below, not the DMP's FIFO overflow.
+    mpu_.setIntEnabled(0);
+#endif
 
     // Set to active-low (1) to trigger the LOW interrupt signal when motion is detected
     // and wake via the interrupt pin which is set to HIGH.
@@ -44,31 +73,277 @@ bool Mpu::Setup(void) {
     // now it reacts to moving/being picked up.
     mpu_.setDHPFMode(MPU6050_DHPF_0P63);
 
-    Log.verbose(F("Interrupt mode       : [%T]\n"), mpu_.getInterruptMode());
-    Log.verbose(F("Interrupt drive      : [%T]\n"), mpu_.getInterruptDrive());
-    Log.verbose(F("Interrupt latch      : [%T]\n"), mpu_.getInterruptLatch());
-    Log.verbose(F("Interrupt latch clean: [%T]\n"), mpu_.getInterruptLatchClear());
-    Log.verbose(F("Interrupt freefall   : [%T]\n"), mpu_.getIntFreefallEnabled());
-    Log.verbose(F("Interrupt motion     : [%T]\n"), mpu_.getIntMotionEnabled());
-    Log.verbose(F("Interrupt zero motion: [%T]\n"), mpu_.getIntZeroMotionEnabled());
-    Log.verbose(F("Interrupt data ready : [%T]\n"), mpu_.getIntDataReadyEnabled());
+#if FAKE_SLEEP_POWER_DOWN
+    // Zero motion is all axes within 16mg of the high-passed reading for
+    // 64ms, clear of the sensor noise, so it ends on the slightest jolt.
+    mpu_.setZeroMotionDetectionThreshold(8);
+    mpu_.setZeroMotionDetectionDuration(1);
+
+    // Free fall is all axes under 40mg, unfiltered, for 5ms.
+    mpu_.setFreefallDetectionThreshold(20);
+    mpu_.setFreefallDetectionDuration(5);
+#endif
+
+#if !POSITION_DMP
+    // Fixed accel output data rate from the 1kHz base rate of the filtered
+    // accelerometer; the 42Hz low-pass keeps it clear of aliasing.
+    mpu_.setDLPFMode(MPU6050_DLPF_BW_42);
+    mpu_.setRate(1000 / MPU_SAMPLE_RATE_HZ - 1);
+    mpu_.setAccelFIFOEnabled(true);
+#endif
+
+#if MPU_LOW_POWER
+    // Only the accelerometer is read. With the gyros stopped, their PLL can't
+    // clock the MPU, as `initialize()` set it to.
+    mpu_.setStandbyXGyroEnabled(true);
+    mpu_.setStandbyYGyroEnabled(true);
+    mpu_.setStandbyZGyroEnabled(true);
+    mpu_.setClockSource(MPU6050_CLOCK_INTERNAL);
+    mpu_.setTempSensorEnabled(false);
+#endif
 
-    Log.verbose(F("Motion detection threshold: [%d]\n"), mpu_.getMotionDetectionThreshold());
-    Log.verbose(F("Motion detection duration : [%d]\n"), mpu_.getMotionDetectionDuration());
+#if POSITION_FUSION
+    // A falling stick turns at up to ~500°/s.
+    mpu_.setFullScaleGyroRange(MPU6050_GYRO_FS_1000);
+    mpu_.setXGyroFIFOEnabled(true);
+    mpu_.setYGyroFIFOEnabled(true);
+    mpu_.setZGyroFIFOEnabled(true);
+#endif
 
-    Log.verbose(F("DLPF Mode: [%d]\n"), mpu_.getDLPFMode());
-    Log.verbose(F("DHPF Mode: [%d]\n"), mpu_.getDHPFMode());
+    StartSampling();
+
+    LOG_VERBOSE("Interrupt mode       : [%T]\n", mpu_.getInterruptMode());
+    LOG_VERBOSE("Interrupt drive      : [%T]\n", mpu_.getInterruptDrive());
+    LOG_VERBOSE("Interrupt latch      : [%T]\n", mpu_.getInterruptLatch());
+    LOG_VERBOSE("Interrupt latch clean: [%T]\n", mpu_.getInterruptLatchClear());
+    LOG_VERBOSE("Interrupt freefall   : [%T]\n", mpu_.getIntFreefallEnabled());
+    LOG_VERBOSE("Interrupt motion     : [%T]\n", mpu_.getIntMotionEnabled());
+    LOG_VERBOSE("Interrupt zero motion: [%T]\n", mpu_.getIntZeroMotionEnabled());
+    LOG_VERBOSE("Interrupt data ready : [%T]\n", mpu_.getIntDataReadyEnabled());
+
+    LOG_VERBOSE("Motion detection threshold: [%d]\n", mpu_.getMotionDetectionThreshold());
+    LOG_VERBOSE("Motion detection duration : [%d]\n", mpu_.getMotionDetectionDuration());
+
+    LOG_VERBOSE("DLPF Mode: [%d]\n", mpu_.getDLPFMode());
+    LOG_VERBOSE("DHPF Mode: [%d]\n", mpu_.getDHPFMode());
 
     return true;
 }
 
-void Mpu::GetAccelMotion(int16_t * x_a, int16_t * y_a, int16_t * z_a) {
-    Log.trace(F("Mpu::GetMotion\n"));
+void Mpu::SetProfile(const Profile profile) {
+#if MPU_LOW_POWER
+    if (profile == profile_) {
+        return;
+    }
+
+    LOG_TRACE("Mpu::SetProfile: %d\n", static_cast<int>(profile));
+
+    // The driver's `MPU6050_WAKE_FREQ_*` are the MPU-6000's rates, LP_WAKE_CTRL
+    // is written directly.
+    if (profile == Profile::kFull) {
+        mpu_.setWakeCycleEnabled(false);
+    } else {
+        mpu_.setWakeFrequency(static_cast<uint8_t>(profile) - static_cast<uint8_t>(Profile::kCycle1Hz25));
+        mpu_.setWakeCycleEnabled(true);
+    }
+
+    profile_ = profile;
+#else
+    (void)profile;
+#endif
+}
+
+void Mpu::StartSampling(void) {
+    LOG_TRACE("Mpu::StartSampling\n");
 
-    // Not used, but needed for the `getMotion6()` API.
-    int16_t x_g = 0;
-    int16_t y_g = 0;
-    int16_t z_g = 0;
+    mpu_.setIntMotionEnabled(false);
+#if FAKE_SLEEP_POWER_DOWN
+    mpu_.setIntZeroMotionEnabled(false);
+    mpu_.setIntFreefallEnabled(false);
+#endif
+
+    mpu_.resetFIFO();
+    mpu_.setFIFOEnabled(true);
+
+    pending_samples_ = 0;
+    attachInterrupt(digitalPinToInterrupt(PIN_INTERRUPT), DataReady, FALLING);
+
+#if POSITION_DMP
+    // Start the fusion over from the accelerometer, the pose may have changed while stopped.
+    mpu_.resetDMP();
+    mpu_.setDMPEnabled(true);
+    mpu_.setIntDMPEnabled(true);
+#else
+    mpu_.setIntDataReadyEnabled(true);
+#endif
+}
+
+void Mpu::StopSampling(void) {
+    LOG_TRACE("Mpu::StopSampling\n");
+
+#if POSITION_DMP
+    mpu_.setIntDMPEnabled(false);
+    mpu_.setDMPEnabled(false);
+#else
+    mpu_.setIntDataReadyEnabled(false);
+#endif
+
+    detachInterrupt(digitalPinToInterrupt(PIN_INTERRUPT));
+
+    mpu_.setFIFOEnabled(false);
+
+    mpu_.setIntMotionEnabled(true);
+}
+
+#if FAKE_SLEEP_POWER_DOWN
+void Mpu::StopSamplingForDoze(void) {
+    LOG_TRACE("Mpu::StopSamplingForDoze\n");
+
+    StopSampling();
+
+    // Drop what was raised while sampling, reading clears it.
+    mpu_.getIntStatus();
+
+    mpu_.setIntZeroMotionEnabled(true);
+    mpu_.setIntFreefallEnabled(true);
+}
+
+bool Mpu::HasMoved(void) {
+    uint8_t status = mpu_.getIntStatus();
+
+    if (status & (_BV(MPU6050_INTERRUPT_MOT_BIT) | _BV(MPU6050_INTERRUPT_FF_BIT))) {
+        return true;
+    }
+
+    // Zero motion interrupts both as it starts and as it ends.
+    return (status & _BV(MPU6050_INTERRUPT_ZMOT_BIT)) && !mpu_.getZeroMotionDetected();
+}
+#endif
 
-    mpu_.getMotion6(x_a, y_a, z_a, &x_g, &y_g, &z_g);
+uint8_t Mpu::ReadAccelSamples(AccelSample * samples, const uint8_t max_samples) {
+    LOG_TRACE("Mpu::ReadAccelSamples\n");
+
+    uint8_t buffer[kFifoSampleBytes * MPU_FIFO_BURST_SAMPLES];
+    uint8_t count = ReadFifoSamples(buffer, max_samples);
+
+    for (uint8_t i = 0; i < count; ++i) {
+        const uint8_t * sample = &buffer[i * kFifoSampleBytes];
+
+        samples[i].x = static_cast<int16_t>((sample[0] << 8) | sample[1]);
+        samples[i].y = static_cast<int16_t>((sample[2] << 8) | sample[3]);
+        samples[i].z = static_cast<int16_t>((sample[4] << 8) | sample[5]);
+    }
+
+    return count;
+}
+
+#if POSITION_FUSION
+uint8_t Mpu::ReadMotionSamples(AccelSample * accel, GyroSample * gyro, const uint8_t max_samples) {
+    LOG_TRACE("Mpu::ReadMotionSamples\n");
+
+    uint8_t buffer[kFifoSampleBytes * MPU_FIFO_BURST_SAMPLES];
+    uint8_t count = ReadFifoSamples(buffer, max_samples);
+
+    for (uint8_t i = 0; i < count; ++i) {
+        const uint8_t * sample = &buffer[i * kFifoSampleBytes];
+
+        accel[i].x = static_cast<int16_t>((sample[0] << 8) | sample[1]);
+        accel[i].y = static_cast<int16_t>((sample[2] << 8) | sample[3]);
+        accel[i].z = static_cast<int16_t>((sample[4] << 8) | sample[5]);
+        gyro[i].x  = static_cast<int16_t>((sample[6] << 8) | sample[7]);
+        gyro[i].y  = static_cast<int16_t>((sample[8] << 8) | sample[9]);
+        gyro[i].z  = static_cast<int16_t>((sample[10] << 8) | sample[11]);
+    }
+
+    return count;
+}
+#endif
+
+uint8_t Mpu::ReadFifoSamples(uint8_t * buffer, const uint8_t max_samples) {
+    uint16_t fifo_count = mpu_.getFIFOCount();
+
+    // A full FIFO overwrites its oldest bytes, after which the samples are no
+    // longer aligned. With no room left for the next sample that can happen
+    // while we read, so start over.
+    if (fifo_count > kFifoSize - kFifoSampleBytes || fifo_count % kFifoSampleBytes != 0) {
+        LOG_WARNING("MPU FIFO overflow, resetting\n");
+        mpu_.resetFIFO();
+        pending_samples_ = 0;
+        return 0;
+    }
+
+    uint8_t available = static_cast<uint8_t>(min(fifo_count / kFifoSampleBytes, UINT8_MAX));
+    uint8_t count     = min(available, max_samples);
+
+    // A burst of accel samples fits in a single `BUFFER_LENGTH` Wire
+    // transfer, I2Cdev splits a longer one.
+    count = min(count, static_cast<uint8_t>(MPU_FIFO_BURST_SAMPLES));
+
+    if (count > 0) {
+        mpu_.getFIFOBytes(buffer, count * kFifoSampleBytes);
+    }
+
+    // Data-ready edges are lost or merged while interrupts are masked, e.g.
+    // during `FastLED.show()`, so the FIFO count is what's really left. Edges
+    // counted since it was read are samples on top of it.
+    uint8_t remaining = available - count;
+    noInterrupts();
+    pending_samples_ = pending_samples_ > count ? pending_samples_ - count : 0;
+    pending_samples_ = max(pending_samples_, remaining);
+    interrupts();
+
+    return count;
+}
+
+#if POSITION_DMP
+bool Mpu::ReadGravity(AccelSample * gravity) {
+    LOG_TRACE("Mpu::ReadGravity\n");
+
+    uint16_t fifo_count = mpu_.getFIFOCount();
+
+    // As for the samples, an overflow leaves the packets misaligned.
+    if (fifo_count > kFifoSize - kDmpPacketBytes || fifo_count % kDmpPacketBytes != 0) {
+        LOG_WARNING("MPU FIFO overflow, resetting\n");
+        mpu_.resetFIFO();
+        pending_samples_ = 0;
+        return false;
+    }
+
+    uint8_t count = static_cast<uint8_t>(fifo_count / kDmpPacketBytes);
+    if (count == 0) {
+        return false;
+    }
+
+    // Only the newest pose matters, the older packets are read to drop them.
+    uint8_t packet[kDmpPacketBytes];
+    for (uint8_t i = 0; i < count; ++i) {
+        mpu_.getFIFOBytes(packet, kDmpPacketBytes);
+    }
+
+    noInterrupts();
+    pending_samples_ = pending_samples_ > count ? pending_samples_ - count : 0;
+    interrupts();
+
+    // Gravity is the quaternion's rotation of the Z axis, as in
+    // `MPU6050::dmpGetGravity()` but in fixed point: with q in Q14, each
+    // product is in Q28 and shifts back to Q14, 16384 for 1g.
+    int16_t q[4];
+    mpu_.dmpGetQuaternion(q, packet);
+
+    gravity->x = static_cast<int16_t>(
+        (2 * (static_cast<int32_t>(q[1]) * q[3] - static_cast<int32_t>(q[0]) * q[2])) >> 14);
+    gravity->y = static_cast<int16_t>(
+        (2 * (static_cast<int32_t>(q[0]) * q[1] + static_cast<int32_t>(q[2]) * q[3])) >> 14);
+    gravity->z = static_cast<int16_t>((static_cast<int32_t>(q[0]) * q[0] - static_cast<int32_t>(q[1]) * q[1] -
+                                       static_cast<int32_t>(q[2]) * q[2] + static_cast<int32_t>(q[3]) * q[3]) >>
+                                      14);
+
+    return true;
+}
+#endif
+
+void Mpu::DataReady(void) {
+    if (pending_samples_ < UINT8_MAX) {
+        ++pending_samples_;
+    }
 }
@@ -1,15 +1,122 @@
 #pragma once
 
+#include "configuration.h"
+
+#if POSITION_DMP
+// Gives `MPU6050` its DMP members, as `MPU6050_6Axis_MotionApps20.h` does.
+#    include "I2Cdev.h"
+#    include "helper_3dmath.h"
+#    define MPU6050_INCLUDE_DMP_MOTIONAPPS20
+#endif
 #include "MPU6050.h"
 
 class Mpu {
   public:
+    struct AccelSample {
+        int16_t x;
+        int16_t y;
+        int16_t z;
+    };
+
+    // Raw at ±1000°/s.
+    struct GyroSample {
+        int16_t x;
+        int16_t y;
+        int16_t z;
+    };
+
+    // What the MPU samples, and the current it draws doing so, from the
+    // MPU-6050 datasheet.
+    enum class Profile : uint8_t {
+        // The accelerometer, and gyros, at MPU_SAMPLE_RATE_HZ: 3.9mA, or
+        // 500uA with MPU_LOW_POWER's gyros in standby.
+        kFull,
+        // The accelerometer alone, waking to take each sample at 1.25, 5, 20
+        // or 40Hz: 10, 20, 70 or 140uA. In the order of LP_WAKE_CTRL.
+        kCycle1Hz25,
+        kCycle5Hz,
+        kCycle20Hz,
+        kCycle40Hz,
+    };
+
     Mpu(void);
 
     bool Setup(void);
 
-    void GetAccelMotion(int16_t * x_a, int16_t * y_a, int16_t * z_a);
+    // Sample the accelerometer into the FIFO at `MPU_SAMPLE_RATE_HZ`, with the
+    // INT pin pulsing data-ready for each sample. With POSITION_DMP, the DMP
+    // queues a packet at `POSITION_DMP_RATE_HZ` instead, pulsing for each.
+    void StartSampling(void);
+
+    // Stop the FIFO and hand the INT pin back to the motion interrupt, to wake from sleep.
+    void StopSampling(void);
+
+#if FAKE_SLEEP_POWER_DOWN
+    // As `StopSampling()`, with the zero-motion and free-fall interrupts on
+    // the INT pin too, to wake as soon as the stick is jolted or dropped.
+    void StopSamplingForDoze(void);
+
+    // Whether the MPU interrupted for the stick moving or dropping since the
+    // last call, rather than only for it coming to rest.
+    bool HasMoved(void);
+#endif
+
+    // Switch what the MPU samples from the next sample on. Without
+    // MPU_LOW_POWER it stays at `kFull`.
+    void SetProfile(const Profile profile);
+
+    // Samples, or DMP packets, counted by the interrupt since the last read,
+    // without touching the bus. The interrupt can miss some, so this only
+    // signals that there's data: a read resets it from the FIFO count.
+    uint8_t GetPendingSamples(void) const { return pending_samples_; }
+
+    // How many samples to read at once: a burst, or each one as it comes
+    // when cycling, which is slow enough to afford it.
+    uint8_t GetBurstSamples(void) const {
+        return profile_ == Profile::kFull ? MPU_FIFO_BURST_SAMPLES : 1;
+    }
+
+    // Read up to `max_samples` (at most one burst) of the oldest samples from
+    // the FIFO, as many as it holds, returns how many were read.
+    uint8_t ReadAccelSamples(AccelSample * samples, const uint8_t max_samples);
+
+#if POSITION_FUSION
+    // As `ReadAccelSamples()`, with the gyro sampled alongside.
+    uint8_t ReadMotionSamples(AccelSample * accel, GyroSample * gyro, const uint8_t max_samples);
+#endif
+
+#if POSITION_DMP
+    // Read every pending DMP packet, and the gravity direction in the newest,
+    // scaled like an accel reading at 2g: 16384 is 1g. Returns whether there
+    // was one.
+    bool ReadGravity(AccelSample * gravity);
+#endif
 
   private:
+    // Accel X, Y and Z, big-endian, then with POSITION_FUSION gyro X, Y and Z.
+#if POSITION_FUSION
+    static const uint8_t kFifoSampleBytes = 12;
+#else
+    static const uint8_t kFifoSampleBytes = 6;
+#endif
+    // I2Cdev counts the bytes of a read in an int8_t.
+    static_assert(kFifoSampleBytes * MPU_FIFO_BURST_SAMPLES <= INT8_MAX,
+                  "MPU_FIFO_BURST_SAMPLES too large for I2Cdev to read a burst");
+
+    static const uint16_t kFifoSize = 1024;
+
+    // The MotionApps 2.0 default packet: quaternion, gyro and accel.
+    static const uint8_t kDmpPacketBytes = 42;
+
+    volatile static uint8_t pending_samples_;
+
     MPU6050 mpu_;
+
+    Profile profile_;
+
+    // Read up to `max_samples` (at most one burst) whole samples from the FIFO
+    // into `buffer`, returns how many were read.
+    uint8_t ReadFifoSamples(uint8_t * buffer, const uint8_t max_samples);
+
+    static void DataReady(void);
 };
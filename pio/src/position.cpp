@@ -1,15 +1,33 @@
 #include "position.h"
 
 #include <Arduino.h>
-#include <ArduinoLog.h>
-#include <RunningMedian.h>
 
+#include "logging.h"
 #include "mpu.h"
+#include "sensorTrace.h"
 #include "stecchino.h"
 
+#define LOG_MODULE_LEVEL LOG_LEVEL_POSITION
+
+#if SENSOR_TRACE && POSITION_DMP
+#    error "SENSOR_TRACE streams the accel samples, which POSITION_DMP doesn't read"
+#endif
+
+#if SENSOR_TRACE && MPU_LOW_POWER
+#    error "SENSOR_TRACE times the samples at MPU_SAMPLE_RATE_HZ, which MPU_LOW_POWER's cycle mode doesn't keep"
+#endif
+
+#if POSITION_DMP && POSITION_FUSION
+#    error "POSITION_DMP and POSITION_FUSION are alternatives"
+#endif
+
 Position::Position(Mpu * mpu) : mpu_(mpu) {}
 
-void Position::Setup(void) {}
+void Position::Setup(void) {
+#if SENSOR_TRACE
+    SensorTrace.WriteHeader(MPU_SAMPLE_RATE_HZ);
+#endif
+}
 
 // Reads acceleration from MPU6050 to evaluate current condition.
 //
@@ -19,93 +37,218 @@ void Position::Setup(void) {}
 //                orientation=POSITION_1 to POSITION_6
 //                angle_to_horizon
 void Position::Update(void) {
-    Log.trace(F("Position::Update\n"));
+    LOG_TRACE("Position::Update\n");
 
-    int16_t ax = 0;
-    int16_t ay = 0;
-    int16_t az = 0;
+    changed_ = false;
 
-    mpu_->GetAccelMotion(&ax, &ay, &az);
+#if POSITION_DMP
+    // The DMP's newest gravity vector, already fused and smoothed.
+    if (mpu_->GetPendingSamples() == 0) {
+        return;
+    }
 
-    // Convert to expected orientation.
-    float forward_accel =
-        static_cast<float>(kAccelOrientation == 0 ? ax : (kAccelOrientation == 1 ? ay : az)) / kMpuUnitConversion_2g;
-    float sideway_accel =
-        static_cast<float>(kAccelOrientation == 0 ? ay : (kAccelOrientation == 1 ? az : ax)) / kMpuUnitConversion_2g;
-    float vertical_accel =
-        static_cast<float>(kAccelOrientation == 0 ? az : (kAccelOrientation == 1 ? ax : ay)) / kMpuUnitConversion_2g;
+    Mpu::AccelSample gravity;
+    if (!mpu_->ReadGravity(&gravity)) {
+        return;
+    }
 
-    forward_rolling_sample_.add(forward_accel);
-    sideway_rolling_sample_.add(sideway_accel);
-    vertical_rolling_sample_.add(vertical_accel);
+    int16_t accel[kAxisCount];
+    Orient(gravity.x, gravity.y, gravity.z, accel);
+
+    Classify(accel[kForward] - CentiG(kForwardOffset),
+             accel[kSideway] - CentiG(kSidewayOffset),
+             accel[kVertical] - CentiG(kVerticalOffset));
+#else
+    // Wait for a whole burst, signalled by the MPU data-ready interrupt.
+    uint8_t burst = mpu_->GetBurstSamples();
+    if (mpu_->GetPendingSamples() < burst) {
+        return;
+    }
+#    if SENSOR_TRACE
+    unsigned long pending_time = micros();
+#    endif
+
+    // Drain what the FIFO held at the first read, including any backlog from a
+    // slow loop, but not samples that arrive meanwhile so a slow drain can't
+    // keep us here.
+    Mpu::AccelSample samples[MPU_FIFO_BURST_SAMPLES];
+    uint8_t          pending = burst;
+    uint8_t          drained = 0;
+#    if POSITION_FUSION
+    Mpu::GyroSample rates[MPU_FIFO_BURST_SAMPLES];
+#    endif
+    while (drained < pending) {
+#    if POSITION_FUSION
+        uint8_t count = mpu_->ReadMotionSamples(samples, rates, min(pending - drained, MPU_FIFO_BURST_SAMPLES));
+#    else
+        uint8_t count = mpu_->ReadAccelSamples(samples, min(pending - drained, MPU_FIFO_BURST_SAMPLES));
+#    endif
+        if (count == 0) {
+            break;
+        }
+        if (drained == 0) {
+            // The whole bursts left after the first read, now counted from the
+            // FIFO. A partial one waits for the next update.
+            uint8_t backlog = mpu_->GetPendingSamples() / burst * burst;
+            pending         = count + min(backlog, UINT8_MAX - count);
+        }
+        for (uint8_t i = 0; i < count; ++i) {
+#    if POSITION_FUSION
+            AddSample(samples[i], rates[i]);
+#    else
+            AddSample(samples[i]);
+#    endif
+        }
+        drained += count;
+#    if SENSOR_TRACE
+        // The newest pending sample arrived about when they were counted.
+        SensorTrace.WriteSamples(pending_time - (pending - drained) * (1000000UL / MPU_SAMPLE_RATE_HZ), samples, count);
+#    endif
+    }
+
+#    if POSITION_FUSION
+    if (drained == 0) {
+        return;
+    }
 
-    float forward_rolling_sample_median  = forward_rolling_sample_.getMedian() - kForwardOffset;
-    float sideway_rolling_sample_median  = sideway_rolling_sample_.getMedian() - kSidewayOffset;
-    float vertical_rolling_sample_median = vertical_rolling_sample_.getMedian() - kVerticalOffset;
+    // As of the newest sample.
+    uint16_t forward_rate = Magnitude(tilt_filter_.GetRate(kForward));
+    uint16_t sideway_rate = Magnitude(tilt_filter_.GetRate(kSideway));
+    tilt_rate_            = static_cast<uint16_t>(10UL * max(forward_rate, sideway_rate) /
+                                           TiltFilter::kGyroDeciLsbPerDegPerSec);
+
+    // Already smoothed by the fusion.
+    Classify(tilt_filter_.GetGravity(kForward) - CentiG(kForwardOffset),
+             tilt_filter_.GetGravity(kSideway) - CentiG(kSidewayOffset),
+             tilt_filter_.GetGravity(kVertical) - CentiG(kVerticalOffset));
+#    else
+    if (rolling_sample_.GetCount() == 0) {
+        return;
+    }
+
+    // Kept in raw readings: scaling to cents of g preserves their order, so
+    // comparing them with each other and with thresholds scaled by `CentiG()`
+    // classifies exactly as comparing cents of g.
+    Classify(rolling_sample_.GetMedian(kForward) - CentiG(kForwardOffset),
+             rolling_sample_.GetMedian(kSideway) - CentiG(kSidewayOffset),
+             rolling_sample_.GetMedian(kVertical) - CentiG(kVerticalOffset));
+#    endif
+#endif
+}
+
+void Position::Classify(const int16_t forward_rolling_sample_median,
+                        const int16_t sideway_rolling_sample_median,
+                        const int16_t vertical_rolling_sample_median) {
+    uint16_t forward_magnitude  = Magnitude(forward_rolling_sample_median);
+    uint16_t sideway_magnitude  = Magnitude(sideway_rolling_sample_median);
+    uint16_t vertical_magnitude = Magnitude(vertical_rolling_sample_median);
+
+    Stecchino::AccelStatus previous_accel_status = accel_status_;
+    Stecchino::Orientation previous_orientation  = orientation_;
+    int16_t                previous_angle        = angle_to_horizon_;
 
     accel_status_ = Stecchino::AccelStatus::kUnknown;
 
     // Evaluate current condition based on smoothed accelarations
-    if (abs(sideway_rolling_sample_median) > abs(vertical_rolling_sample_median) ||
-        abs(forward_rolling_sample_median) > abs(vertical_rolling_sample_median)) {
-        Log.verbose(F("AccelStatus: Fallen\n"));
+    if (sideway_magnitude > vertical_magnitude || forward_magnitude > vertical_magnitude) {
+        LOG_VERBOSE("AccelStatus: Fallen\n");
         accel_status_ = Stecchino::AccelStatus::kFallen;
-    } else if (abs(sideway_rolling_sample_median) < abs(vertical_rolling_sample_median) &&
-               abs(forward_rolling_sample_median) < abs(vertical_rolling_sample_median)) {
-        Log.verbose(F("AccelStatus: Straight\n"));
+    } else if (sideway_magnitude < vertical_magnitude && forward_magnitude < vertical_magnitude) {
+        LOG_VERBOSE("AccelStatus: Straight\n");
         accel_status_ = Stecchino::AccelStatus::kStraight;
     }
 
-    if (vertical_rolling_sample_median >= 80 && abs(forward_rolling_sample_median) <= 25 &&
-        abs(sideway_rolling_sample_median) <= 25) {
+    if (vertical_rolling_sample_median >= CentiG(80) && forward_magnitude <= CentiG(25) &&
+        sideway_magnitude <= CentiG(25)) {
         // Stecchino vertical with PCB down (easy game position = straight)
-        Log.verbose(F("Orientation: Position 6\n"));
+        LOG_VERBOSE("Orientation: Position 6\n");
         orientation_ = Stecchino::Orientation::kPosition_6;
-    } else if (forward_rolling_sample_median >= 80 && abs(vertical_rolling_sample_median) <= 25 &&
-               abs(sideway_rolling_sample_median) <= 25) {
+    } else if (forward_rolling_sample_median >= CentiG(80) && vertical_magnitude <= CentiG(25) &&
+               sideway_magnitude <= CentiG(25)) {
         // Stecchino horizontal with buttons down (force sleep)
-        Log.verbose(F("Orientation: Position 2\n"));
+        LOG_VERBOSE("Orientation: Position 2\n");
         orientation_ = Stecchino::Orientation::kPosition_2;
-    } else if (vertical_rolling_sample_median <= -80 && abs(forward_rolling_sample_median) <= 25 &&
-               abs(sideway_rolling_sample_median) <= 25) {
+    } else if (vertical_rolling_sample_median <= CentiG(-80) && forward_magnitude <= CentiG(25) &&
+               sideway_magnitude <= CentiG(25)) {
         // Stecchino vertical with PCB up (normal game position = straight)
-        Log.verbose(F("Orientation: Position 5\n"));
+        LOG_VERBOSE("Orientation: Position 5\n");
         orientation_ = Stecchino::Orientation::kPosition_5;
-    } else if (forward_rolling_sample_median <= -80 && abs(vertical_rolling_sample_median) <= 25 &&
-               abs(sideway_rolling_sample_median) <= 25) {
+    } else if (forward_rolling_sample_median <= CentiG(-80) && vertical_magnitude <= CentiG(25) &&
+               sideway_magnitude <= CentiG(25)) {
         // Stecchino horizontal with buttons up (idle)
-        Log.verbose(F("Orientation: Position 1\n"));
+        LOG_VERBOSE("Orientation: Position 1\n");
         orientation_ = Stecchino::Orientation::kPosition_1;
-    } else if (sideway_rolling_sample_median >= 80 && abs(vertical_rolling_sample_median) <= 25 &&
-               abs(forward_rolling_sample_median) <= 25) {
+    } else if (sideway_rolling_sample_median >= CentiG(80) && vertical_magnitude <= CentiG(25) &&
+               forward_magnitude <= CentiG(25)) {
         // Stecchino horizontal with long edge down (spirit level)
-        Log.verbose(F("Orientation: Position 3\n"));
+        LOG_VERBOSE("Orientation: Position 3\n");
         orientation_ = Stecchino::Orientation::kPosition_3;
-    } else if (sideway_rolling_sample_median <= -80 && abs(vertical_rolling_sample_median) <= 25 &&
-               abs(forward_rolling_sample_median) <= 25) {
+    } else if (sideway_rolling_sample_median <= CentiG(-80) && vertical_magnitude <= CentiG(25) &&
+               forward_magnitude <= CentiG(25)) {
         // Stecchino horizontal with short edge down (opposite to spirit level)
-        Log.verbose(F("Orientation: Position 4\n"));
+        LOG_VERBOSE("Orientation: Position 4\n");
         orientation_ = Stecchino::Orientation::kPosition_4;
     } else {
         // TODO throw an error?
     }
 
-    angle_to_horizon_ = atan2(float(vertical_rolling_sample_median),
-                              float(max(abs(sideway_rolling_sample_median), abs(forward_rolling_sample_median)))) *
-                        180 / PI;
+    // Clamped to fit `Atan2CentiDegrees()`, for a saturated -2g reading.
+    uint16_t horizontal_magnitude = min(max(sideway_magnitude, forward_magnitude), 0x7FFF);
+
+    int16_t angle_to_horizon =
+        Atan2CentiDegrees(vertical_rolling_sample_median, static_cast<int16_t>(horizontal_magnitude));
+    angle_to_horizon_ = angle_to_horizon / 100;
+
+    changed_ = (accel_status_ != previous_accel_status || orientation_ != previous_orientation ||
+                angle_to_horizon_ != previous_angle);
 
-    Log.notice(F("Forward: %F Sideway: %F Vertical: %F angle_to_horizon: %F orientation: %d accel_status: %d\n"),
-               forward_rolling_sample_median,
-               sideway_rolling_sample_median,
-               vertical_rolling_sample_median,
+#if FALL_PREDICTION
+    // Upright either way up, the tilt is from the nearer vertical.
+    bool was_falling = falling_;
+    fall_predictor_.Add(static_cast<uint16_t>(millis()), 9000 - static_cast<int16_t>(Magnitude(angle_to_horizon)));
+    falling_ = fall_predictor_.GetConfidence() >= FALL_PREDICTION_MIN_CONFIDENCE;
+    changed_ = changed_ || falling_ != was_falling;
+#endif
+
+    LOG_NOTICE("Forward: %d Sideway: %d Vertical: %d angle_to_horizon: %d orientation: %d accel_status: %d\n",
+               forward_rolling_sample_median / kMpuUnitConversion_2g,
+               sideway_rolling_sample_median / kMpuUnitConversion_2g,
+               vertical_rolling_sample_median / kMpuUnitConversion_2g,
                angle_to_horizon_,
                static_cast<int>(orientation_),
                static_cast<int>(accel_status_));
 }
 
-// Clear running median buffer.
-void Position::ClearSampleBuffer(void) {
-    forward_rolling_sample_.clear();
-    sideway_rolling_sample_.clear();
-    vertical_rolling_sample_.clear();
+void Position::Orient(const int16_t x, const int16_t y, const int16_t z, int16_t axes[kAxisCount]) const {
+    // Convert to expected orientation.
+    axes[kForward]  = kAccelOrientation == 0 ? x : (kAccelOrientation == 1 ? y : z);
+    axes[kSideway]  = kAccelOrientation == 0 ? y : (kAccelOrientation == 1 ? z : x);
+    axes[kVertical] = kAccelOrientation == 0 ? z : (kAccelOrientation == 1 ? x : y);
 }
+
+#if POSITION_DMP
+// Nothing to clear, the DMP keeps no sample history here.
+void Position::ClearSampleBuffer(void) {}
+#elif POSITION_FUSION
+void Position::AddSample(const Mpu::AccelSample & accel, const Mpu::GyroSample & gyro) {
+    int16_t oriented_accel[kAxisCount];
+    int16_t oriented_gyro[kAxisCount];
+    Orient(accel.x, accel.y, accel.z, oriented_accel);
+    Orient(gyro.x, gyro.y, gyro.z, oriented_gyro);
+
+    tilt_filter_.Update(oriented_accel, oriented_gyro);
+}
+
+// Start the estimate over from the accelerometer.
+void Position::ClearSampleBuffer(void) { tilt_filter_.Reset(); }
+#else
+void Position::AddSample(const Mpu::AccelSample & sample) {
+    int16_t accel[kAxisCount];
+    Orient(sample.x, sample.y, sample.z, accel);
+
+    rolling_sample_.Add(accel);
+}
+
+// Clear running median buffer.
+void Position::ClearSampleBuffer(void) { rolling_sample_.Clear(); }
+#endif
@@ -1,11 +1,14 @@
 #pragma once
 
 #include <Arduino.h>
-#include <RunningMedian.h>
 
 #include "configuration.h"
+#include "fallPredictor.h"
+#include "fixedPoint.h"
+#include "medianFilter.h"
 #include "mpu.h"
 #include "stecchino.h"
+#include "tiltFilter.h"
 
 class Position {
   public:
@@ -21,33 +24,85 @@ class Position {
 
     Stecchino::Orientation GetOrientation(void) const { return orientation_; }
 
-    float GetAngleToHorizon(void) const { return angle_to_horizon_; }
+    // In whole degrees, truncated toward zero.
+    int16_t GetAngleToHorizon(void) const { return angle_to_horizon_; }
+
+    // Whether the last `Update()` changed the accel status, orientation or
+    // angle to horizon, or with FALL_PREDICTION whether the stick is falling.
+    bool HasChanged(void) const { return changed_; }
+
+#if FALL_PREDICTION
+    // From 0 to 255, how sure `FallPredictor` is that the stick is falling.
+    uint8_t GetFallConfidence(void) const { return fall_predictor_.GetConfidence(); }
+
+    // Whether the stick is falling past recovery, maybe still short of 45°.
+    bool IsFalling(void) const { return falling_; }
+#endif
+
+#if POSITION_FUSION
+    // How fast the stick is tipping over, in whole °/s: its rate about the
+    // forward or sideway axis, whichever is faster.
+    uint16_t GetTiltRate(void) const { return tilt_rate_; }
+#endif
 
   private:
-    // Offset accel readings
+    // Offset accel readings, in cents of g
     // const int kForwardOffset = -2;
     // const int kSidewayOffset = 2;
     // const int kVerticalOffset = 1;
 
-    const float kForwardOffset  = 0.;
-    const float kSidewayOffset  = 0.;
-    const float kVerticalOffset = 0.;
+    static const int16_t kForwardOffset  = 0;
+    static const int16_t kSidewayOffset  = 0;
+    static const int16_t kVerticalOffset = 0;
 
-    const uint8_t kRunningMedianBufferSize = 5;
+#if !POSITION_DMP && !POSITION_FUSION
+    static const uint8_t kRunningMedianBufferSize = POSITION_MEDIAN_WINDOW;
+#endif
+
+    // Rolling sample axes, in `MedianFilter` channel order.
+    enum Axis : uint8_t { kForward, kSideway, kVertical, kAxisCount };
 
     // Unit conversion to "cents of g" for MPU range set to 2g
-    const float kMpuUnitConversion_2g = 164.;
+    static const int16_t kMpuUnitConversion_2g = 164;
+
+    // Raw accel reading for `centi_g` cents of g.
+    static constexpr int16_t CentiG(const int16_t centi_g) { return centi_g * kMpuUnitConversion_2g; }
 
     const uint8_t kAccelOrientation = ACCELEROMETER_ORIENTATION;
 
-    float angle_to_horizon_ = 0.;
+    int16_t angle_to_horizon_ = 0;
+
+#if POSITION_FUSION
+    TiltFilter tilt_filter_;
 
-    RunningMedian forward_rolling_sample_  = RunningMedian(kRunningMedianBufferSize);
-    RunningMedian sideway_rolling_sample_  = RunningMedian(kRunningMedianBufferSize);
-    RunningMedian vertical_rolling_sample_ = RunningMedian(kRunningMedianBufferSize);
+    uint16_t tilt_rate_ = 0;
+#elif !POSITION_DMP
+    // Raw accel readings.
+    MedianFilter<int16_t, kAxisCount, kRunningMedianBufferSize> rolling_sample_;
+#endif
 
     Stecchino::AccelStatus accel_status_ = Stecchino::AccelStatus::kUnknown;
     Stecchino::Orientation orientation_  = Stecchino::Orientation::kUnknown;
 
+    bool changed_ = false;
+
+#if FALL_PREDICTION
+    FallPredictor fall_predictor_;
+
+    bool falling_ = false;
+#endif
+
     Mpu * mpu_;
+
+    // Convert a reading of the sensor's X, Y and Z to the forward, sideway and vertical axes.
+    void Orient(const int16_t x, const int16_t y, const int16_t z, int16_t axes[kAxisCount]) const;
+
+#if POSITION_FUSION
+    void AddSample(const Mpu::AccelSample & accel, const Mpu::GyroSample & gyro);
+#else
+    void AddSample(const Mpu::AccelSample & sample);
+#endif
+
+    // Classify the pose from raw accel readings, less their offsets.
+    void Classify(const int16_t forward, const int16_t sideway, const int16_t vertical);
 };
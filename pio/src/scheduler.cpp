@@ -0,0 +1,114 @@
+#include "scheduler.h"
+
+#include <Arduino.h>
+
+#include "logging.h"
+
+#define LOG_MODULE_LEVEL LOG_LEVEL_SCHEDULER
+
+Scheduler::Scheduler(void) : task_count_(0) {}
+
+int8_t Scheduler::AddTask(TaskFunction function, unsigned long period_us) {
+    if (task_count_ >= kMaxTasks) {
+        LOG_ERROR("Scheduler::AddTask: task table full\n");
+        return -1;
+    }
+
+    Task & task      = tasks_[task_count_];
+    task.function    = function;
+    task.period_us   = period_us;
+    task.next_run_us = micros();
+    task.runs        = 0;
+    task.overruns    = 0;
+    task.max_late_us = 0;
+    task.armed       = true;
+
+    return static_cast<int8_t>(task_count_++);
+}
+
+int8_t Scheduler::AddTimer(TaskFunction function) {
+    int8_t timer = AddTask(function, 0);
+    if (timer >= 0) {
+        tasks_[timer].armed = false;
+    }
+    return timer;
+}
+
+void Scheduler::StartTimer(const int8_t timer, unsigned long delay_us) {
+    tasks_[timer].next_run_us = micros() + delay_us;
+    tasks_[timer].armed       = true;
+}
+
+void Scheduler::StopTimer(const int8_t timer) {
+    tasks_[timer].armed = false;
+}
+
+bool Scheduler::Run(void) {
+    unsigned long now = micros();
+
+    // Of the due tasks, run the one that has waited longest past its tick;
+    // ties go to the task added first.
+    Task * next    = nullptr;
+    long   late_us = -1;
+    for (uint8_t i = 0; i < task_count_; ++i) {
+        if (!tasks_[i].armed) {
+            continue;
+        }
+
+        // Signed difference so the comparison survives `micros()` wrapping.
+        long task_late_us = static_cast<long>(now - tasks_[i].next_run_us);
+        if (task_late_us > late_us) {
+            next    = &tasks_[i];
+            late_us = task_late_us;
+        }
+    }
+
+    if (next == nullptr) {
+        return false;
+    }
+
+    if (static_cast<unsigned long>(late_us) > next->max_late_us) {
+        next->max_late_us = late_us;
+    }
+
+    if (next->period_us == 0) {
+        // A timer, done until started again.
+        next->armed = false;
+    } else if (static_cast<unsigned long>(late_us) >= next->period_us) {
+        // Drop the missed ticks and restart the period from now.
+        next->overruns += late_us / next->period_us;
+        next->next_run_us = now + next->period_us;
+    } else {
+        next->next_run_us += next->period_us;
+    }
+
+    ++next->runs;
+    next->function();
+    return true;
+}
+
+void Scheduler::Resync(void) {
+    unsigned long now = micros();
+
+    for (uint8_t i = 0; i < task_count_; ++i) {
+        if (tasks_[i].period_us != 0) {
+            tasks_[i].next_run_us = now;
+        }
+    }
+}
+
+// At 9600 baud each line costs the other tasks ~50 ms, so only the tasks
+// that have overrun are logged. Timers never overrun.
+void Scheduler::LogReport(void) const {
+    for (uint8_t i = 0; i < task_count_; ++i) {
+        if (tasks_[i].overruns == 0) {
+            continue;
+        }
+
+        LOG_NOTICE("Task %d: runs %l, overruns %l, max late %l us\n",
+                   i,
+                   tasks_[i].runs,
+                   tasks_[i].overruns,
+                   tasks_[i].max_late_us);
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+
+// Cooperative fixed-rate scheduler for `loop()`.
+//
+// Each `Run()` runs the due task that is furthest past its tick, so a slow
+// task delays a faster one by at most its own run time and no task starves
+// when the loop is overloaded. A task that starts a whole period or more late
+// has missed ticks: they are counted as overruns and dropped rather than run
+// back to back.
+//
+// A timer is a task that runs once, when the delay it was last started with
+// has passed, and is idle until started again.
+class Scheduler {
+  public:
+    typedef void (*TaskFunction)(void);
+
+    static const uint8_t kMaxTasks = 5;
+
+    Scheduler(void);
+
+    // Returns the task index, or -1 if the task table is full.
+    int8_t AddTask(TaskFunction function, unsigned long period_us);
+
+    // Returns the task index of a stopped timer, or -1 if the task table is full.
+    int8_t AddTimer(TaskFunction function);
+
+    // Run the timer once `delay_us` from now, replacing any earlier start.
+    void StartTimer(const int8_t timer, unsigned long delay_us);
+
+    void StopTimer(const int8_t timer);
+
+    // Run the most overdue task, if any is due. Returns true if one ran.
+    bool Run(void);
+
+    // Restart every period from now without counting overruns, after the
+    // device was deliberately stopped (e.g. asleep). Timers keep their delays.
+    void Resync(void);
+
+    unsigned long GetRuns(const uint8_t task) const { return tasks_[task].runs; }
+
+    unsigned long GetOverruns(const uint8_t task) const { return tasks_[task].overruns; }
+
+    unsigned long GetMaxLateMicros(const uint8_t task) const { return tasks_[task].max_late_us; }
+
+    uint8_t GetTaskCount(void) const { return task_count_; }
+
+    void LogReport(void) const;
+
+  private:
+    struct Task {
+        TaskFunction  function;
+        // 0 for a timer.
+        unsigned long period_us;
+        unsigned long next_run_us;
+        unsigned long runs;
+        unsigned long overruns;
+        unsigned long max_late_us;
+        // Always set for a periodic task, set for a timer while started.
+        bool armed;
+    };
+
+    Task    tasks_[kMaxTasks];
+    uint8_t task_count_;
+};
@@ -0,0 +1,66 @@
+#include "sensorTrace.h"
+
+SensorTracing SensorTrace;
+
+void SensorTracing::WriteHeader(const uint16_t sample_rate_hz) {
+    Payload payload;
+    payload.AppendInt16(static_cast<int16_t>(sample_rate_hz));
+    WriteRecord(kHeaderType, payload);
+}
+
+void SensorTracing::WriteSamples(const unsigned long micros, const Mpu::AccelSample * samples, const uint8_t count) {
+    if (count == 0 || count > kMaxSamples) {
+        return;
+    }
+
+    Payload payload;
+    payload.Append(static_cast<uint8_t>(micros));
+    payload.Append(static_cast<uint8_t>(micros >> 8));
+    payload.Append(static_cast<uint8_t>(micros >> 16));
+    payload.Append(static_cast<uint8_t>(micros >> 24));
+    payload.Append(count);
+
+    payload.AppendInt16(samples[0].x);
+    payload.AppendInt16(samples[0].y);
+    payload.AppendInt16(samples[0].z);
+    for (uint8_t i = 1; i < count; ++i) {
+        // Consecutive samples are close, most changes fit in a byte.
+        payload.AppendVarint(static_cast<int16_t>(samples[i].x - samples[i - 1].x));
+        payload.AppendVarint(static_cast<int16_t>(samples[i].y - samples[i - 1].y));
+        payload.AppendVarint(static_cast<int16_t>(samples[i].z - samples[i - 1].z));
+    }
+
+    WriteRecord(kSamplesType, payload);
+}
+
+void SensorTracing::Payload::AppendInt16(const int16_t value) {
+    Append(static_cast<uint8_t>(value));
+    Append(static_cast<uint8_t>(static_cast<uint16_t>(value) >> 8));
+}
+
+// Wraps like int16 arithmetic, the host adds the changes back the same way.
+void SensorTracing::Payload::AppendVarint(const int16_t value) {
+    uint16_t zigzag = (static_cast<uint16_t>(value) << 1) ^ static_cast<uint16_t>(value >> 15);
+    while (zigzag >= 0x80) {
+        Append(static_cast<uint8_t>(zigzag | 0x80));
+        zigzag >>= 7;
+    }
+    Append(static_cast<uint8_t>(zigzag));
+}
+
+void SensorTracing::WriteRecord(const uint8_t type, const Payload & payload) {
+    if (output_ == nullptr) {
+        return;
+    }
+
+    uint8_t checksum = type ^ payload.size;
+    for (uint8_t i = 0; i < payload.size; ++i) {
+        checksum ^= payload.bytes[i];
+    }
+
+    output_->write(kSync);
+    output_->write(type);
+    output_->write(payload.size);
+    output_->write(payload.bytes, payload.size);
+    output_->write(checksum);
+}
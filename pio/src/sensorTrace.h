@@ -0,0 +1,63 @@
+#pragma once
+
+// Streams the raw accelerometer samples, as `Position` reads them, for replay
+// on the host (see `native/hal/traceSource.h` and `tools/sensor_trace.py`).
+//
+// Each record is:
+//
+//   0xD7, type, payload length, payload, XOR of type, length and payload
+//
+// with, all little-endian:
+//
+//   'H' header:  sample rate (uint16, Hz)
+//   'S' samples: `micros()` of the last sample (uint32), sample count
+//                (uint8), the first sample's x, y and z (int16), then for
+//                each following sample the change of x, y and z from the
+//                previous one as zigzag varints
+//
+// Samples are `1 / sample rate` apart, the last one is the newest.
+//
+// The sync byte is not ASCII, so records can share the port with text logs.
+
+#include <stdint.h>
+
+#include <Arduino.h>
+
+#include "configuration.h"
+#include "mpu.h"
+
+class SensorTracing {
+  public:
+    static const uint8_t kSync           = 0xD7;
+    static const uint8_t kHeaderType     = 'H';
+    static const uint8_t kSamplesType    = 'S';
+    static const uint8_t kMaxSamples     = MPU_FIFO_BURST_SAMPLES;
+    static const uint8_t kMaxPayloadSize = 4 + 1 + 6 + (kMaxSamples - 1) * 3 * 3;
+
+    SensorTracing(void) : output_(nullptr) {}
+
+    void begin(Print * output) { output_ = output; }
+
+    void WriteHeader(const uint16_t sample_rate_hz);
+
+    // At most `kMaxSamples`, in the order they were sampled, `micros` being
+    // when the last one was.
+    void WriteSamples(const unsigned long micros, const Mpu::AccelSample * samples, const uint8_t count);
+
+  private:
+    // Built on the stack, so tracing costs no SRAM while it is off.
+    struct Payload {
+        uint8_t bytes[kMaxPayloadSize];
+        uint8_t size = 0;
+
+        void Append(const uint8_t value) { bytes[size++] = value; }
+        void AppendInt16(const int16_t value);
+        void AppendVarint(const int16_t value);
+    };
+
+    Print * output_;
+
+    void WriteRecord(const uint8_t type, const Payload & payload);
+};
+
+extern SensorTracing SensorTrace;
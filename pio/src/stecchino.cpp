@@ -11,66 +11,179 @@
 // Local
 #include "behavior.h"
 #include "configuration.h"
+#include "dischargeLog.h"
+#include "dutyCycle.h"
 #include "ledStrip.h"
+#include "logging.h"
 #include "mpu.h"
 #include "position.h"
+#include "scheduler.h"
+#include "sensorTrace.h"
 #include "stecchino.h"
 
+#define LOG_MODULE_LEVEL LOG_LEVEL_STECCHINO
+
 Behavior *     behavior;
 BatteryLevel * battery_level;
+#if DISCHARGE_LOG
+DischargeLog * discharge_log;
+#endif
+DutyCycle *    duty_cycle;
 LedStrip *     led_strip;
 Mpu *          mpu;
 Position *     position;
+Scheduler *    scheduler;
+
+void UpdateBehavior(void) {
+    Stecchino::AccelStatus accel_status = position->GetAccelStatus();
+#if FALL_PREDICTION
+    // A fall past recovery ends the game without waiting for 45°.
+    if (position->IsFalling()) {
+        accel_status = Stecchino::AccelStatus::kFallen;
+    }
+#endif
+    behavior->Update(position->GetAngleToHorizon(), accel_status, position->GetOrientation());
+}
+
+// The current state's time limit passed.
+void ExpireBehavior(void) {
+    Stecchino::State previous_state = behavior->GetState();
+
+    // Report while nothing else needs the CPU, at 9600 baud it takes ~350 ms.
+    if (previous_state == Stecchino::State::kSleepTransition) {
+        duty_cycle->LogReport();
+    }
+
+    behavior->Expire();
+
+    // Powered down in between, the sleep is not time awake.
+    bool powered_down = previous_state == Stecchino::State::kSleepTransition;
+#if FAKE_SLEEP_POWER_DOWN
+    powered_down = powered_down || previous_state == Stecchino::State::kFakeSleep;
+#endif
+    if (powered_down) {
+        duty_cycle->Restart();
+    }
+}
+
+// Sample the MPU and hand any change straight to Behavior, so a fall is
+// handled within one sample period however long the LEDs take to draw.
+void UpdatePosition(void) {
+    position->Update();
+
+    if (position->HasChanged()) {
+        UpdateBehavior();
+    }
+}
+
+// Draw the current state's frame, if it animates, and show it. The readings
+// reach Behavior as they change, from `UpdatePosition()`.
+void UpdateLedStrip(void) {
+    behavior->Draw();
+
+    led_strip->Update();
+}
+
+void UpdateBatteryLevel(void) {
+    battery_level->Update();
+
+#if LED_POWER_BUDGET
+    led_strip->SetSupplyMillivolts(battery_level->GetMillivolts());
+#endif
+
+#if DISCHARGE_LOG
+    discharge_log->Sample(behavior->GetState(), led_strip->GetBrightness(), battery_level->GetMillivolts());
+
+    // Only when asked, a reset doesn't fill the port with the whole log.
+    if (Serial.read() == DischargeLog::kDumpCommand) {
+        discharge_log->Dump(&Serial);
+    }
+#endif
+}
+
+void LogSchedulerReport(void) {
+    scheduler->LogReport();
+}
 
 void setup() {
+#if SENSOR_TRACE
+    Serial.begin(SENSOR_TRACE_BAUD);
+#else
     Serial.begin(9600);
+#endif
     while (!Serial) {
         // Wait for the Serial port to be ready.
         delay(100);
     }
 
+#if LOG_BINARY
+    BinaryLog.begin(&Serial);
+#else
     Log.begin(LOG_LEVEL_VERBOSE, &Serial, true);
-    Log.trace(F("setup(): start\n"));
+#endif
+#if SENSOR_TRACE
+    SensorTrace.begin(&Serial);
+#endif
+    LOG_TRACE("setup(): start\n");
 
     pinMode(PIN_INTERRUPT, INPUT_PULLUP);
 
-    led_strip = new LedStrip();
+    // Placed statically rather than on the heap, so the build's memory map
+    // accounts for them (see `tools/memory_map.py`), and still constructed
+    // here, in order, as each needs what was set up before it.
+    static LedStrip led_strip_instance;
+    led_strip = &led_strip_instance;
     led_strip->Setup();
 
-    battery_level = new BatteryLevel();
-
-    mpu = new Mpu();
+    static BatteryLevel battery_level_instance;
+    battery_level = &battery_level_instance;
+    battery_level->Setup();
+#if LED_POWER_BUDGET
+    led_strip->SetSupplyMillivolts(battery_level->GetMillivolts());
+#endif
+
+#if DISCHARGE_LOG
+    static DischargeLog discharge_log_instance;
+    discharge_log = &discharge_log_instance;
+    discharge_log->Setup();
+#endif
+
+    static Mpu mpu_instance;
+    mpu = &mpu_instance;
     if (!mpu->Setup()) {
-        Log.fatal(F("Failed to setup the MPU\n"));
+        LOG_FATAL("Failed to setup the MPU\n");
         Serial.flush();
         // TODO display error code pattern for MPU.
         exit(1);
     }
 
-    position = new Position(mpu);
+    static Position position_instance(mpu);
+    position = &position_instance;
     position->Setup();
 
-    behavior = new Behavior(led_strip, mpu, battery_level);
+    static Scheduler scheduler_instance;
+    scheduler = &scheduler_instance;
+    scheduler->AddTask(UpdatePosition, 1000000UL / POSITION_UPDATES_PER_SECOND);
+    scheduler->AddTask(UpdateLedStrip, 1000000UL / FRAMES_PER_SECOND);
+    scheduler->AddTask(LogSchedulerReport, 1000UL * SCHEDULER_REPORT_MS);
+    scheduler->AddTask(UpdateBatteryLevel, 1000UL * BATTERY_REFRESH_MS);
+    int8_t behavior_timer = scheduler->AddTimer(ExpireBehavior);
+
+    static Behavior behavior_instance(led_strip, mpu, battery_level, scheduler, behavior_timer);
+    behavior = &behavior_instance;
     behavior->Setup();
 
-    Log.trace(F("setup(): end\n"));
+    static DutyCycle duty_cycle_instance;
+    duty_cycle = &duty_cycle_instance;
+
+    LOG_TRACE("setup(): end\n");
 }
 
 Stecchino::State state;
 Stecchino::State previous_state;
 
 void loop() {
-    Log.trace(F("loop(): start\n"));
-
-    position->Update();
-
-    float                  angle_to_horizon = position->GetAngleToHorizon();
-    Stecchino::AccelStatus accel_status     = position->GetAccelStatus();
-    Stecchino::Orientation orientation      = position->GetOrientation();
-
-    behavior->Update(angle_to_horizon, accel_status, orientation);
-
-    led_strip->Update();
-
-    Log.trace(F("loop(): end\n"));
+    if (!scheduler->Run()) {
+        duty_cycle->Idle(behavior->GetState());
+    }
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdint.h>
+
 namespace Stecchino {
 
 enum class State : int {
@@ -14,6 +16,9 @@ enum class State : int {
     kStartPlayTransition,
 };
 
+// States are numbered from kUnknown up to kStartPlayTransition, the last.
+const uint8_t kStateCount = static_cast<uint8_t>(State::kStartPlayTransition) + 1;
+
 enum class AccelStatus : int {
     kUnknown = 0,
     kFallen,
@@ -0,0 +1,48 @@
+#include "tiltFilter.h"
+
+TiltFilter::TiltFilter(void) : bias_{0, 0, 0}, rate_{0, 0, 0} { Reset(); }
+
+void TiltFilter::Reset(void) { started_ = false; }
+
+void TiltFilter::Update(const int16_t accel[kAxes], const int16_t gyro[kAxes]) {
+    if (!started_) {
+        for (uint8_t axis = 0; axis < kAxes; ++axis) {
+            gravity_[axis] = static_cast<int32_t>(accel[axis]) << kFractionBits;
+        }
+        started_ = true;
+    }
+
+    int16_t gravity[kAxes];
+    for (uint8_t axis = 0; axis < kAxes; ++axis) {
+        gravity[axis] = GetGravity(axis);
+    }
+
+    // How far, and about which axis, the accelerometer disagrees with the
+    // estimate. Held there, it's the gyro bias.
+    int32_t error[kAxes];
+    HalfCross(accel, gravity, error);
+
+    for (uint8_t axis = 0; axis < kAxes; ++axis) {
+        bias_[axis] -= error[axis] >> (POSITION_FUSION_BIAS_SHIFT - 1);
+        rate_[axis] = Clamp(gyro[axis] - (bias_[axis] >> 16));
+    }
+
+    int32_t turn[kAxes];
+    HalfCross(gravity, rate_, turn);
+
+    for (uint8_t axis = 0; axis < kAxes; ++axis) {
+        gravity_[axis] += ((turn[axis] >> 11) * kTurnGain) >> 9;
+        gravity_[axis] += ((static_cast<int32_t>(accel[axis]) << kFractionBits) - gravity_[axis]) >>
+                          POSITION_FUSION_PULL_SHIFT;
+    }
+}
+
+void TiltFilter::HalfCross(const int16_t a[kAxes], const int16_t b[kAxes], int32_t product[kAxes]) {
+    product[0] = (static_cast<int32_t>(a[1]) * b[2] >> 1) - (static_cast<int32_t>(a[2]) * b[1] >> 1);
+    product[1] = (static_cast<int32_t>(a[2]) * b[0] >> 1) - (static_cast<int32_t>(a[0]) * b[2] >> 1);
+    product[2] = (static_cast<int32_t>(a[0]) * b[1] >> 1) - (static_cast<int32_t>(a[1]) * b[0] >> 1);
+}
+
+int16_t TiltFilter::Clamp(const int32_t value) {
+    return value > INT16_MAX ? INT16_MAX : (value < INT16_MIN ? INT16_MIN : static_cast<int16_t>(value));
+}
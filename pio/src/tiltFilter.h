@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "configuration.h"
+
+// Gravity direction fused from the gyro and accelerometer, in integer math
+// only.
+//
+// Each sample turns the estimate by the gyro rate, which follows a fall as it
+// happens, then pulls it toward the accelerometer so the gyro's drift can't
+// build up. As in a Mahony filter, the cross product of the two, the rotation
+// between them, is integrated into the gyro bias, so a gyro offset doesn't
+// tilt the estimate. See POSITION_FUSION_PULL_SHIFT for the gains.
+//
+// Kept in Q8 of the raw accel readings, 256 × 16384 for 1g at ±2g, and the
+// gyro is read at ±1000°/s.
+class TiltFilter {
+  public:
+    static const uint8_t kAxes = 3;
+
+    // Raw gyro LSB per °/s at ±1000°/s, in tenths.
+    static const uint16_t kGyroDeciLsbPerDegPerSec = 328;
+
+    TiltFilter(void);
+
+    // Start over from the next accelerometer reading, keeping the gyro bias.
+    void Reset(void);
+
+    // Add one sample of each, raw and in the same axes.
+    void Update(const int16_t accel[kAxes], const int16_t gyro[kAxes]);
+
+    // Raw accel reading of gravity along `axis`.
+    int16_t GetGravity(const uint8_t axis) const { return static_cast<int16_t>(gravity_[axis] >> kFractionBits); }
+
+    // Raw gyro reading about `axis`, less its bias.
+    int16_t GetRate(const uint8_t axis) const { return rate_[axis]; }
+
+  private:
+    static const uint8_t kFractionBits = 8;
+
+    // Turns `g × ω`, halved, into the change of the estimate over a sample:
+    // radians per raw gyro LSB times `dt`, in Q20 with the halving and the
+    // estimate's Q8 folded in.
+    static constexpr int32_t kTurnGain =
+        static_cast<int32_t>(2.0 * (1L << kFractionBits) * (1L << 20) * 3.14159265 * 10 /
+                                 (180.0 * kGyroDeciLsbPerDegPerSec * MPU_SAMPLE_RATE_HZ) +
+                             0.5);
+    static_assert(kTurnGain < 4096, "MPU_SAMPLE_RATE_HZ too low for the TiltFilter turn to fit 32 bits");
+
+    int32_t gravity_[kAxes];
+
+    // In Q16 of the raw gyro readings.
+    int32_t bias_[kAxes];
+
+    int16_t rate_[kAxes];
+
+    bool started_;
+
+    // Half of `a × b`, which can't overflow.
+    static void HalfCross(const int16_t a[kAxes], const int16_t b[kAxes], int32_t product[kAxes]);
+
+    static int16_t Clamp(const int32_t value);
+};
@@ -0,0 +1,237 @@
+#!/usr/bin/env python3
+"""Ask the firmware for its discharge log and fit a discharge model.
+
+With DISCHARGE_LOG, the firmware keeps an entry per DISCHARGE_LOG_PERIOD_S of
+on-time in EEPROM: Vcc at the end of the period, the state the period was
+mostly spent in and the mean brightness (see src/dischargeLog.h). It writes
+the whole log to Serial when it reads a `d` there, which this sends to a
+serial port until the log comes back:
+
+    stty -F /dev/ttyUSB0 9600 raw
+    tools/discharge_log.py csv /dev/ttyUSB0 > log.csv
+    tools/discharge_log.py fit /dev/ttyUSB0
+
+or from a capture, `cat /dev/ttyUSB0 > dump.bin` while sending the `d`, or
+the native build's `--serial --send d` output.
+
+`fit` splits the log into charges, at each rise of Vcc, and fits two models:
+
+  drain:   mV lost per hour of on-time in each state, from the periods where
+           Vcc is below the regulator's output. Above it Vcc stays flat
+           whatever the load, so only the end of a charge shows a slope.
+  runtime: the share of a charge used per hour in each state, from the
+           charges that were run down to the cutoff, and the hours a full
+           charge lasts in each state and in the logged mix.
+"""
+
+import argparse
+import os
+import select
+import signal
+import stat
+import struct
+import sys
+import time
+
+SYNC = 0xD7
+PERIOD = ord('P')
+ENTRIES = ord('D')
+ENTRY_SIZE = 4
+ERASED = 0xFF
+
+# In the order of `Stecchino::State`.
+STATES = [
+    'Unknown',
+    'CheckBattery',
+    'FakeSleep',
+    'GameOverTransition',
+    'Idle',
+    'Play',
+    'SleepTransition',
+    'SpiritLevel',
+    'StartPlayTransition',
+]
+
+DEFAULT_PERIOD_S = 60
+
+DUMP_COMMAND = b'd'
+
+
+def read_input(path, seconds):
+    """Read a capture file, stdin, or the dump asked of a serial port."""
+    if path is None or path == '-':
+        return sys.stdin.buffer.read()
+    if not stat.S_ISCHR(os.stat(path).st_mode):
+        with open(path, 'rb') as stream:
+            return stream.read()
+
+    data = bytearray()
+    descriptor = os.open(path, os.O_RDWR | os.O_NOCTTY)
+    try:
+        deadline = time.time() + seconds
+        while time.time() < deadline:
+            # Opening the port may reset the board, ask again until it's up.
+            dumped = any(record_type == ENTRIES for record_type, _ in records(data))
+            if not dumped:
+                os.write(descriptor, DUMP_COMMAND)
+            ready, _, _ = select.select([descriptor], [], [], 1.0)
+            if ready:
+                data += os.read(descriptor, 4096)
+            elif dumped:
+                # The dump is done once the port goes quiet.
+                break
+    finally:
+        os.close(descriptor)
+    return bytes(data)
+
+
+def records(data):
+    """Yield (type, payload) for each valid log record in `data`."""
+    i = 0
+    while i + 4 <= len(data):
+        if data[i] != SYNC:
+            i += 1
+            continue
+        record_type = data[i + 1]
+        size = data[i + 2]
+        if record_type not in (PERIOD, ENTRIES) or i + 4 + size > len(data):
+            i += 1
+            continue
+        payload = data[i + 3:i + 3 + size]
+        checksum = record_type ^ size
+        for byte in payload:
+            checksum ^= byte
+        if checksum != data[i + 3 + size]:
+            i += 1
+            continue
+        yield record_type, payload
+        i += 4 + size
+
+
+def entries(data):
+    """Return the period in seconds and the (state, brightness, mV) entries, oldest first.
+
+    A capture may hold several dumps, each of the whole log: the last one wins.
+    """
+    period_s = DEFAULT_PERIOD_S
+    log = []
+    for record_type, payload in records(data):
+        if record_type == PERIOD and len(payload) >= 2:
+            period_s = max(1, struct.unpack_from('<H', payload)[0])
+            log = []
+            continue
+        for offset in range(0, len(payload) - ENTRY_SIZE + 1, ENTRY_SIZE):
+            sequence, state, brightness, vcc = payload[offset:offset + ENTRY_SIZE]
+            if sequence == ERASED or state >= len(STATES):
+                continue
+            log.append((state, brightness, 2000 + 10 * vcc))
+    return period_s, log
+
+
+def charges(log, recharge_mv):
+    """Split the log where Vcc rises by `recharge_mv` or more."""
+    runs = []
+    for entry in log:
+        if not runs or entry[2] - runs[-1][-1][2] >= recharge_mv:
+            runs.append([])
+        runs[-1].append(entry)
+    return runs
+
+
+def solve(rows, values, ridge=1e-9):
+    """Least squares for x in rows · x = values, by the normal equations."""
+    n = len(rows[0])
+    a = [[sum(row[i] * row[j] for row in rows) + (ridge if i == j else 0.) for j in range(n)] for i in range(n)]
+    b = [sum(row[i] * value for row, value in zip(rows, values)) for i in range(n)]
+    for column in range(n):
+        pivot = max(range(column, n), key=lambda r: abs(a[r][column]))
+        a[column], a[pivot] = a[pivot], a[column]
+        b[column], b[pivot] = b[pivot], b[column]
+        if abs(a[column][column]) < 1e-12:
+            continue
+        for r in range(n):
+            if r != column:
+                factor = a[r][column] / a[column][column]
+                a[r] = [x - factor * y for x, y in zip(a[r], a[column])]
+                b[r] -= factor * b[column]
+    return [b[i] / a[i][i] if abs(a[i][i]) >= 1e-12 else 0. for i in range(n)]
+
+
+def fit(args):
+    period_s, log = entries(read_input(args.input, args.seconds))
+    if not log:
+        sys.exit('no discharge log entries')
+    period_h = period_s / 3600.
+    runs = charges(log, args.recharge_mv)
+
+    used = sorted({state for state, _, _ in log})
+    print('%d entries of %d s, %.1f h of on-time, %d charges\n' % (len(log), period_s, len(log) * period_h, len(runs)))
+    print('%-20s %8s %11s %12s %14s %12s' % ('state', 'hours', 'brightness', 'drain mV/h', 'charge %/h', 'runtime h'))
+
+    # Drain: each period below regulation loses `drain[state] * period` mV.
+    drops = {state: [] for state in used}
+    for run in runs:
+        for previous, current in zip(run, run[1:]):
+            if previous[2] < args.regulated_mv:
+                drops[current[0]].append((previous[2] - current[2]) / period_h)
+
+    # Runtime: each complete charge used up all of it, the sum over its
+    # periods of `share[state] * period`.
+    complete = [run for run in runs if run[-1][2] <= args.cutoff_mv]
+    share = {}
+    if len(complete) >= len(used):
+        rows = [[period_h * sum(1 for entry in run if entry[0] == state) for state in used] for run in complete]
+        share = dict(zip(used, solve(rows, [1.] * len(rows))))
+
+    for state in used:
+        periods = [entry for entry in log if entry[0] == state]
+        drain = '%12.1f' % (sum(drops[state]) / len(drops[state])) if drops[state] else '%12s' % '-'
+        if share.get(state, 0) > 0:
+            charge = '%14.1f %12.1f' % (100 * share[state], 1 / share[state])
+        else:
+            charge = '%14s %12s' % ('-', '-')
+        print('%-20s %8.2f %11.0f %s %s' % (STATES[state], len(periods) * period_h,
+                                            sum(entry[1] for entry in periods) / len(periods), drain, charge))
+
+    if share:
+        mix = sum(share[entry[0]] for entry in log) / len(log)
+        print('\nA full charge lasts %.1f h of on-time in the logged mix of states.' % (1 / mix if mix > 0 else 0))
+    else:
+        print('\n%d complete charges, down to %d mV: at least %d are needed to fit the runtime.' %
+              (len(complete), args.cutoff_mv, len(used)))
+
+
+def csv(args):
+    period_s, log = entries(read_input(args.input, args.seconds))
+    print('minutes,state,brightness,mv')
+    for i, (state, brightness, millivolts) in enumerate(log):
+        print('%g,%s,%d,%d' % ((i + 1) * period_s / 60., STATES[state], brightness, millivolts))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--seconds', type=float, default=10, help='longest to read a serial port for')
+    commands = parser.add_subparsers(dest='command')
+    commands.required = True
+
+    csv_parser = commands.add_parser('csv', help='print the entries as CSV, with their on-time')
+    csv_parser.add_argument('input', nargs='?', help='serial port or capture, default stdin')
+    csv_parser.set_defaults(run=csv)
+
+    fit_parser = commands.add_parser('fit', help='fit the drain and runtime per state')
+    fit_parser.add_argument('input', nargs='?', help='serial port or capture, default stdin')
+    fit_parser.add_argument('--regulated-mv', type=int, default=3300, help='regulator output, default %(default)s')
+    fit_parser.add_argument('--cutoff-mv', type=int, default=2800, help='Vcc a charge ends at, default %(default)s')
+    fit_parser.add_argument('--recharge-mv', type=int, default=50, help='Vcc rise of a recharge, default %(default)s')
+    fit_parser.set_defaults(run=fit)
+
+    args = parser.parse_args()
+
+    # Quietly stop when piped into `head` and the like.
+    signal.signal(signal.SIGPIPE, signal.SIG_DFL)
+
+    args.run(args)
+
+
+if __name__ == '__main__':
+    main()
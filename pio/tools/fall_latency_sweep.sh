@@ -0,0 +1,32 @@
+#!/bin/sh
+# Runs the fall latency benchmark for each combination of median window,
+# sample rate and burst size, rebuilding it with the settings overridden.
+#
+#   tools/fall_latency_sweep.sh [--falls N]
+#
+# The lists can be overridden from the environment, e.g.
+#
+#   WINDOWS="1 5 9" RATES=200 BURSTS="1 4" tools/fall_latency_sweep.sh
+#
+# Rows marked invalid overflowed the MPU FIFO: the firmware fell behind the
+# sample rate, and the latency is that of the backlog.
+
+set -e
+
+cd "$(dirname "$0")/.."
+
+WINDOWS=${WINDOWS:-"1 3 5 7 9"}
+RATES=${RATES:-"100 200 500"}
+BURSTS=${BURSTS:-"1 4"}
+
+header=""
+for window in $WINDOWS; do
+    for rate in $RATES; do
+        for burst in $BURSTS; do
+            PLATFORMIO_BUILD_FLAGS="-DPOSITION_MEDIAN_WINDOW=$window -DMPU_SAMPLE_RATE_HZ=$rate -DMPU_FIFO_BURST_SAMPLES=$burst" \
+                platformio run --silent --environment native_fall_latency_benchmark
+            .pioenvs/native_fall_latency_benchmark/program $header "$@"
+            header="--no-header"
+        done
+    done
+done
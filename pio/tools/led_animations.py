@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+"""Generate the flash-resident LED animations from their description.
+
+Reads tools/led_animations.txt and writes src/ledAnimations.cpp, the
+run-length-encoded frames that `LedStrip::DrawFrame()` decodes (see
+src/ledAnimations.h for the format). Color names are those of FastLED's
+`CRGB::HTMLColorCode`, read from its pixeltypes.h.
+
+    tools/led_animations.py
+    tools/led_animations.py --check
+"""
+
+import argparse
+import os
+import re
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+DESCRIPTION = os.path.join(ROOT, 'tools', 'led_animations.txt')
+CONFIGURATION = os.path.join(ROOT, 'src', 'configuration.h')
+PIXELTYPES = os.path.join(ROOT, '..', 'Arduino_librairies', 'FastLED', 'pixeltypes.h')
+OUTPUT = os.path.join(ROOT, 'src', 'ledAnimations.cpp')
+
+MAX_RUN = 255
+
+COLOR_CODE = re.compile(r'^\s*(\w+)\s*=\s*0x([0-9A-Fa-f]{6})\s*,', re.MULTILINE)
+NUM_LEDS = re.compile(r'^#define\s+NUM_LEDS\s+(\d+)', re.MULTILINE)
+NAME = re.compile(r'^[A-Z]\w*$')
+
+
+def read(path):
+    with open(path) as stream:
+        return stream.read()
+
+
+def color_value(text, colors, where):
+    if re.match(r'^#[0-9A-Fa-f]{6}$', text):
+        value = int(text[1:], 16)
+    elif text in colors:
+        value = colors[text]
+    else:
+        sys.exit('%s: unknown color %r' % (where, text))
+    return (value >> 16) & 0xFF, (value >> 8) & 0xFF, value & 0xFF
+
+
+def parse_frame(text, colors, leds, where):
+    """Return the frame's runs as (count, r, g, b), merged and split to fit a byte."""
+    runs = []
+    total = 0
+    for run in text.split(','):
+        fields = run.split()
+        if len(fields) != 2:
+            sys.exit('%s: expected `count color`, got %r' % (where, run.strip()))
+        count = leds - total if fields[0] == '*' else int(fields[0])
+        if count < 0 or total + count > leds:
+            sys.exit('%s: runs cover more than the %d LEDs' % (where, leds))
+        total += count
+        color = color_value(fields[1], colors, where)
+        if runs and runs[-1][1:] == color:
+            count += runs.pop()[0]
+        runs.append((count,) + color)
+
+    # A trailing black run is implied.
+    if runs and runs[-1][1:] == (0, 0, 0):
+        runs.pop()
+
+    split = []
+    for count, r, g, b in runs:
+        while count > 0:
+            split.append((min(count, MAX_RUN), r, g, b))
+            count -= MAX_RUN
+    return split
+
+
+def parse(description, colors, leds):
+    animations = []
+    for number, line in enumerate(description.splitlines(), 1):
+        line = line.split('#', 1)[0].strip()
+        if not line:
+            continue
+        where = 'led_animations.txt:%d' % number
+        name, _, frames = line.partition(':')
+        name = name.strip()
+        if not NAME.match(name):
+            sys.exit('%s: expected `Name: frames`' % where)
+        frames = [parse_frame(frame, colors, leds, where) for frame in frames.split('|')]
+        if len(frames) > 255:
+            sys.exit('%s: more than 255 frames' % where)
+        animations.append((name, frames))
+    return animations
+
+
+def generate(animations, leds):
+    lines = [
+        '// Generated by tools/led_animations.py from tools/led_animations.txt, do not edit.',
+        '',
+        '#include "ledAnimations.h"',
+        '',
+        '#include <avr/pgmspace.h>',
+        '',
+        '#include "configuration.h"',
+        '',
+        '#if NUM_LEDS != %d' % leds,
+        '#    error "NUM_LEDS changed, rerun tools/led_animations.py"',
+        '#endif',
+    ]
+    for name, frames in animations:
+        size = 1 + sum(4 * len(runs) + 1 for runs in frames)
+        lines += ['', '// %d frames, %d bytes.' % (len(frames), size) if len(frames) > 1 else '// %d bytes.' % size]
+        lines.append('const uint8_t k%sAnimation[] PROGMEM = {' % name)
+        lines.append('    %d,' % len(frames))
+        for runs in frames:
+            for count, r, g, b in runs:
+                lines.append('    %d, 0x%02X, 0x%02X, 0x%02X,' % (count, r, g, b))
+            lines.append('    0,')
+        lines.append('};')
+    return '\n'.join(lines) + '\n'
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--check', action='store_true', help='fail if the generated source is out of date')
+    args = parser.parse_args()
+
+    colors = {name: int(value, 16) for name, value in COLOR_CODE.findall(read(PIXELTYPES))}
+    leds = int(NUM_LEDS.search(read(CONFIGURATION)).group(1))
+    animations = parse(read(DESCRIPTION), colors, leds)
+    source = generate(animations, leds)
+
+    if args.check:
+        if not os.path.exists(OUTPUT) or read(OUTPUT) != source:
+            sys.exit('%s is out of date, run tools/led_animations.py' % os.path.relpath(OUTPUT))
+        return
+    with open(OUTPUT, 'w') as stream:
+        stream.write(source)
+    print('wrote %s, %d animations' % (os.path.relpath(OUTPUT), len(animations)))
+
+
+if __name__ == '__main__':
+    main()
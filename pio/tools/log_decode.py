@@ -0,0 +1,235 @@
+#!/usr/bin/env python3
+"""Decode the binary log records written with LOG_BINARY back into text.
+
+Message IDs are hashes of the format strings, so the decoder finds every
+LOG_*() call in the firmware sources, hashes its format string the same way
+as `LogId()` in src/logging.h and formats the arguments as ArduinoLog would.
+
+    stty -F /dev/ttyUSB0 9600 raw && tools/log_decode.py < /dev/ttyUSB0
+    tools/log_decode.py capture.bin
+"""
+
+import argparse
+import glob
+import os
+import re
+import signal
+import struct
+import sys
+
+SYNC = 0xA5
+
+LEVEL_PREFIXES = {
+    'FATAL': 'F',
+    'ERROR': 'E',
+    'WARNING': 'W',
+    'NOTICE': 'N',
+    'TRACE': 'T',
+    'VERBOSE': 'V',
+}
+
+LOG_CALL = re.compile(r'LOG_(FATAL|ERROR|WARNING|NOTICE|TRACE|VERBOSE)\(\s*((?:"(?:[^"\\]|\\.)*"\s*)+)')
+STRING_LITERAL = re.compile(r'"((?:[^"\\]|\\.)*)"')
+
+ESCAPES = {'n': '\n', 't': '\t', 'r': '\r', '0': '\0', '\\': '\\', '"': '"', "'": "'"}
+
+
+def unescape(literal):
+    out = []
+    i = 0
+    while i < len(literal):
+        c = literal[i]
+        if c == '\\' and i + 1 < len(literal):
+            i += 1
+            out.append(ESCAPES.get(literal[i], literal[i]))
+        else:
+            out.append(c)
+        i += 1
+    return ''.join(out)
+
+
+def log_id(format_string):
+    """FNV-1a folded to 16 bits, as `LogId()`."""
+    value = 2166136261
+    for byte in format_string.encode('latin-1'):
+        value = ((value ^ byte) * 16777619) & 0xFFFFFFFF
+    return (value ^ (value >> 16)) & 0xFFFF
+
+
+def load_messages(source_dir):
+    messages = {}
+    for path in sorted(glob.glob(os.path.join(source_dir, '*.cpp')) + glob.glob(os.path.join(source_dir, '*.h'))):
+        with open(path) as source:
+            text = source.read()
+        for match in LOG_CALL.finditer(text):
+            level = match.group(1)
+            format_string = ''.join(unescape(s) for s in STRING_LITERAL.findall(match.group(2)))
+            line = text.count('\n', 0, match.start()) + 1
+            message_id = log_id(format_string)
+            known = messages.get(message_id)
+            if known and known[1] != format_string:
+                sys.exit('%s:%d: message ID 0x%04X collides with %s, reword one of them' %
+                         (path, line, message_id, known[2]))
+            messages[message_id] = (level, format_string, '%s:%d' % (os.path.basename(path), line))
+    return messages
+
+
+def conversions(format_string):
+    """Conversion characters of the format string, in order."""
+    specs = []
+    i = 0
+    while i < len(format_string):
+        if format_string[i] == '%' and i + 1 < len(format_string):
+            i += 1
+            if format_string[i] != '%':
+                specs.append(format_string[i])
+        i += 1
+    return specs
+
+
+class Truncated(Exception):
+    pass
+
+
+class Reader(object):
+
+    def __init__(self, data, position):
+        self.data = data
+        self.position = position
+
+    def byte(self):
+        if self.position >= len(self.data):
+            raise Truncated()
+        value = self.data[self.position]
+        self.position += 1
+        return value
+
+    def varint(self):
+        zigzag = 0
+        shift = 0
+        while True:
+            byte = self.byte()
+            zigzag |= (byte & 0x7F) << shift
+            shift += 7
+            if not byte & 0x80:
+                break
+        return (zigzag >> 1) ^ -(zigzag & 1)
+
+    def float(self):
+        return struct.unpack('<f', bytes(self.byte() for _ in range(4)))[0]
+
+    def string(self):
+        chars = []
+        while True:
+            byte = self.byte()
+            if byte == 0:
+                return bytes(chars).decode('latin-1')
+            chars.append(byte)
+
+
+def read_argument(reader, spec):
+    if spec in 'DF':
+        return reader.float()
+    if spec in 'sS':
+        return reader.string()
+    return reader.varint()
+
+
+def format_argument(spec, value):
+    if spec in 'DF':
+        return '%.2f' % value
+    if spec in 'sS':
+        return value
+    if spec in 'dil':
+        return '%d' % value
+    if spec == 'x':
+        return '%X' % (value & 0xFFFF if value < 0 else value)
+    if spec == 'X':
+        return '0x%X' % (value & 0xFFFF if value < 0 else value)
+    if spec == 'b':
+        return format(value & 0xFFFF if value < 0 else value, 'b')
+    if spec == 'B':
+        return '0b' + format(value & 0xFFFF if value < 0 else value, 'b')
+    if spec == 'c':
+        return chr(value & 0xFF)
+    if spec == 't':
+        return 'T' if value == 1 else 'F'
+    if spec == 'T':
+        return 'true' if value == 1 else 'false'
+    return '%' + spec
+
+
+def render(format_string, values):
+    out = []
+    values = iter(values)
+    i = 0
+    while i < len(format_string):
+        c = format_string[i]
+        if c == '%' and i + 1 < len(format_string):
+            i += 1
+            spec = format_string[i]
+            out.append('%' if spec == '%' else format_argument(spec, next(values)))
+        else:
+            out.append(c)
+        i += 1
+    return ''.join(out)
+
+
+def decode(data, messages, show_level, output):
+    """Decode all complete records in `data`, returns the undecoded tail."""
+    position = 0
+    while True:
+        start = data.find(bytes([SYNC]), position)
+        if start < 0:
+            return b''
+        reader = Reader(data, start + 1)
+        try:
+            message_id = reader.byte() | (reader.byte() << 8)
+            message = messages.get(message_id)
+            if message is None:
+                # Not a record start, or a message from other sources.
+                position = start + 1
+                continue
+            level, format_string, _ = message
+            specs = conversions(format_string)
+            values = [read_argument(reader, spec) for spec in specs]
+        except Truncated:
+            return data[start:]
+        if show_level:
+            output.write(LEVEL_PREFIXES[level] + ': ')
+        output.write(render(format_string, values))
+        output.flush()
+        position = reader.position
+
+
+def main():
+    default_sources = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'src')
+
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('input', nargs='?', help='binary capture, default stdin')
+    parser.add_argument('--sources', default=default_sources, help='firmware sources (default: %(default)s)')
+    parser.add_argument('--no-level', action='store_true', help='omit the level prefix')
+    parser.add_argument('--list', action='store_true', help='list the message IDs and exit')
+    args = parser.parse_args()
+
+    # Quietly stop when piped into `head` and the like.
+    signal.signal(signal.SIGPIPE, signal.SIG_DFL)
+
+    messages = load_messages(args.sources)
+
+    if args.list:
+        for message_id, (level, format_string, location) in sorted(messages.items()):
+            print('0x%04X %-7s %-20s %r' % (message_id, level, location, format_string))
+        return
+
+    stream = open(args.input, 'rb') if args.input else sys.stdin.buffer
+    pending = b''
+    while True:
+        chunk = stream.read1(4096) if hasattr(stream, 'read1') else stream.read(4096)
+        if not chunk:
+            break
+        pending = decode(pending + chunk, messages, not args.no_level, sys.stdout)
+
+
+if __name__ == '__main__':
+    main()
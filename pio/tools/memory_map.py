@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+"""Break a firmware ELF's SRAM and flash use down by object, and check the headroom.
+
+SRAM holds .data, .bss and .noinit, the stack grows down from the top into
+what is left, and the firmware keeps nothing on the heap. The check fails when
+less than SRAM_HEADROOM_BYTES (src/configuration.h) would be left for the
+stack, as a collision there corrupts globals silently.
+
+The protrinket3ftdi build runs it after linking, see
+tools/memory_map_build.py. By hand:
+
+    tools/memory_map.py .pioenvs/protrinket3ftdi/firmware.elf
+    tools/memory_map.py --nm avr-nm --top 0 firmware.elf
+"""
+
+import argparse
+import collections
+import os
+import re
+import signal
+import subprocess
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+CONFIGURATION = os.path.join(ROOT, 'src', 'configuration.h')
+
+# ATmega328P, and the Pro Trinket's flash less its 4 KB bootloader.
+DEFAULT_RAM = 2048
+DEFAULT_FLASH = 28672
+
+# AVR data addresses are offset into their own space.
+AVR_RAM_OFFSET = 0x800000
+
+RAM_SECTIONS = ('.data', '.bss', '.noinit')
+FLASH_SECTIONS = ('.text', '.data')
+
+NM_LINE = re.compile(r'^([0-9a-fA-F]+)\s+([0-9a-fA-F]+)\s+(\w)\s+(.*)$')
+HEADROOM = re.compile(r'^#define\s+SRAM_HEADROOM_BYTES\s+(\d+)', re.MULTILINE)
+
+Symbol = collections.namedtuple('Symbol', 'name size ram')
+
+
+def run(command):
+    try:
+        return subprocess.check_output(command, universal_newlines=True)
+    except (OSError, subprocess.CalledProcessError) as error:
+        sys.exit('%s: %s' % (command[0], error))
+
+
+def sections(size_tool, elf):
+    """Return the size of each section, from `size -A`."""
+    sizes = {}
+    for line in run([size_tool, '-A', elf]).splitlines():
+        fields = line.split()
+        if len(fields) == 3 and fields[0].startswith('.') and fields[1].isdigit():
+            sizes[fields[0]] = int(fields[1])
+    return sizes
+
+
+def symbols(nm, elf):
+    """Return the ELF's sized symbols, each in SRAM or in flash."""
+    result = []
+    for line in run([nm, '--print-size', '--size-sort', '--demangle', elf]).splitlines():
+        match = NM_LINE.match(line)
+        if not match:
+            continue
+        address, size, kind, name = match.groups()
+        if kind in 'Uuw':
+            continue
+        address = int(address, 16)
+        ram = address >= AVR_RAM_OFFSET or kind in 'bBdD'
+        result.append(Symbol(name, int(size, 16), ram))
+    return sorted(result, key=lambda symbol: (-symbol.size, symbol.name))
+
+
+def headroom_from_configuration():
+    with open(CONFIGURATION) as stream:
+        match = HEADROOM.search(stream.read())
+    return int(match.group(1)) if match else 0
+
+
+def print_objects(title, objects, top):
+    shown = objects if top <= 0 else objects[:top]
+    print('\n%s, %d objects%s' % (title, len(objects), '' if len(shown) == len(objects) else ', largest %d' % top))
+    for symbol in shown:
+        print('%7d  %s' % (symbol.size, symbol.name))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('elf', help='linked firmware')
+    parser.add_argument('--nm', default='avr-nm', help='nm of the toolchain, default %(default)s')
+    parser.add_argument('--size', help='size of the toolchain, default next to --nm')
+    parser.add_argument('--ram', type=int, default=DEFAULT_RAM, help='SRAM bytes, default %(default)s')
+    parser.add_argument('--flash', type=int, default=DEFAULT_FLASH, help='flash bytes, default %(default)s')
+    parser.add_argument('--headroom', type=int, help='SRAM bytes to leave, default SRAM_HEADROOM_BYTES')
+    parser.add_argument('--top', type=int, default=20, help='objects to list per memory, 0 for all')
+    args = parser.parse_args()
+
+    # Quietly stop when piped into `head` and the like.
+    signal.signal(signal.SIGPIPE, signal.SIG_DFL)
+
+    size_tool = args.size or re.sub(r'nm(\.exe)?$', r'size\1', args.nm)
+    headroom = args.headroom if args.headroom is not None else headroom_from_configuration()
+
+    sizes = sections(size_tool, args.elf)
+    ram_used = sum(sizes.get(section, 0) for section in RAM_SECTIONS)
+    flash_used = sum(sizes.get(section, 0) for section in FLASH_SECTIONS)
+    left = args.ram - ram_used
+
+    print('SRAM  %6d of %6d bytes (%s), %d left for the stack, at least %d wanted' %
+          (ram_used, args.ram, ', '.join('%s %d' % (section, sizes.get(section, 0)) for section in RAM_SECTIONS), left,
+           headroom))
+    print('flash %6d of %6d bytes (.text %d, .data %d)' %
+          (flash_used, args.flash, sizes.get('.text', 0), sizes.get('.data', 0)))
+
+    objects = symbols(args.nm, args.elf)
+    print_objects('SRAM by object', [symbol for symbol in objects if symbol.ram], args.top)
+    print_objects('flash by object', [symbol for symbol in objects if not symbol.ram], args.top)
+
+    failed = False
+    if left < headroom:
+        print('\nSRAM headroom %d bytes is under SRAM_HEADROOM_BYTES %d' % (left, headroom))
+        failed = True
+    if flash_used > args.flash:
+        print('\nflash use %d bytes is over the %d available' % (flash_used, args.flash))
+        failed = True
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == '__main__':
+    main()
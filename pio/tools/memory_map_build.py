@@ -0,0 +1,23 @@
+# PlatformIO extra script: runs tools/memory_map.py on the linked firmware and
+# fails the build when it does, see there.
+
+import os
+
+Import('env')  # noqa: F821
+
+
+def memory_map(source, target, env):
+    board = env.BoardConfig()
+    nm = env.subst('$CC').replace('gcc', 'nm')
+    command = [
+        env.subst('$PYTHONEXE'),
+        os.path.join(env.subst('$PROJECT_DIR'), 'tools', 'memory_map.py'),
+        '--nm', nm,
+        '--ram', str(board.get('upload.maximum_ram_size', 2048)),
+        '--flash', str(board.get('upload.maximum_size', 28672)),
+        source[0].get_abspath(),
+    ]
+    return env.Execute(' '.join('"%s"' % argument for argument in command))
+
+
+env.AddPostAction('$BUILD_DIR/${PROGNAME}.elf', memory_map)  # noqa: F821
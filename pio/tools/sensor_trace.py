@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+"""Capture and export the sensor traces streamed with SENSOR_TRACE.
+
+The firmware writes binary records (see src/sensorTrace.h) to Serial,
+interleaved with any text logs. `extract` keeps only the valid records, the
+compact trace that the native build replays, and `csv` exports the samples
+with their times.
+
+    stty -F /dev/ttyUSB0 115200 raw && cat /dev/ttyUSB0 > capture.bin
+    tools/sensor_trace.py extract capture.bin session.trace
+    tools/sensor_trace.py csv session.trace > session.csv
+    .pioenvs/native/program --states --frames --replay session.trace
+"""
+
+import argparse
+import signal
+import struct
+import sys
+
+SYNC = 0xD7
+HEADER = ord('H')
+SAMPLES = ord('S')
+
+DEFAULT_SAMPLE_RATE_HZ = 200
+
+
+def records(data):
+    """Yield (type, payload, raw record) for each valid record in `data`."""
+    i = 0
+    while i + 4 <= len(data):
+        if data[i] != SYNC:
+            i += 1
+            continue
+        record_type = data[i + 1]
+        size = data[i + 2]
+        if record_type not in (HEADER, SAMPLES) or i + 4 + size > len(data):
+            i += 1
+            continue
+        payload = data[i + 3:i + 3 + size]
+        checksum = record_type ^ size
+        for byte in payload:
+            checksum ^= byte
+        if checksum != data[i + 3 + size]:
+            i += 1
+            continue
+        yield record_type, payload, data[i:i + 4 + size]
+        i += 4 + size
+
+
+def varints(payload, position):
+    while position < len(payload):
+        zigzag = 0
+        shift = 0
+        while True:
+            byte = payload[position]
+            position += 1
+            zigzag |= (byte & 0x7F) << shift
+            shift += 7
+            if not byte & 0x80:
+                break
+        yield (zigzag >> 1) ^ -(zigzag & 1)
+
+
+def wrap_int16(value):
+    return (value + 0x8000) % 0x10000 - 0x8000
+
+
+def samples(data):
+    """Yield (micros, x, y, z) for each sample, as the native replay places them."""
+    sample_rate_hz = DEFAULT_SAMPLE_RATE_HZ
+    clock_high = 0
+    last = None
+    for record_type, payload, _ in records(data):
+        if record_type == HEADER and len(payload) >= 2:
+            sample_rate_hz = max(1, struct.unpack_from('<H', payload)[0])
+            continue
+        if record_type != SAMPLES or len(payload) < 11:
+            continue
+
+        last_us = clock_high | struct.unpack_from('<I', payload)[0]
+        if last is not None and last_us + 0x80000000 < last:
+            clock_high += 1 << 32
+            last_us += 1 << 32
+
+        count = payload[4]
+        accels = [struct.unpack_from('<hhh', payload, 5)]
+        changes = list(varints(payload, 11))
+        for i in range(0, 3 * (count - 1), 3):
+            x, y, z = accels[-1]
+            dx, dy, dz = changes[i:i + 3]
+            accels.append((wrap_int16(x + dx), wrap_int16(y + dy), wrap_int16(z + dz)))
+
+        period_us = 1000000 // sample_rate_hz
+        for i, (x, y, z) in enumerate(accels):
+            micros = max(0, last_us - period_us * (len(accels) - 1 - i))
+            if last is not None and micros <= last:
+                micros = last + 1
+            last = micros
+            yield micros, x, y, z
+
+
+def read_input(path):
+    if path is None or path == '-':
+        return sys.stdin.buffer.read()
+    with open(path, 'rb') as stream:
+        return stream.read()
+
+
+def extract(args):
+    data = read_input(args.input)
+    trace = [raw for _, _, raw in records(data)]
+    with open(args.output, 'wb') as output:
+        for raw in trace:
+            output.write(raw)
+    sys.stderr.write('%d records, %d of %d bytes\n' % (len(trace), sum(len(raw) for raw in trace), len(data)))
+
+
+def csv(args):
+    print('micros,ax,ay,az')
+    for sample in samples(read_input(args.input)):
+        print('%d,%d,%d,%d' % sample)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest='command')
+    commands.required = True
+
+    extract_parser = commands.add_parser('extract', help='keep only the trace records of a capture')
+    extract_parser.add_argument('input', help='raw capture, - for stdin')
+    extract_parser.add_argument('output', help='trace file to write')
+    extract_parser.set_defaults(run=extract)
+
+    csv_parser = commands.add_parser('csv', help='print the samples as CSV')
+    csv_parser.add_argument('input', nargs='?', help='trace or raw capture, default stdin')
+    csv_parser.set_defaults(run=csv)
+
+    args = parser.parse_args()
+
+    # Quietly stop when piped into `head` and the like.
+    signal.signal(signal.SIGPIPE, signal.SIG_DFL)
+
+    args.run(args)
+
+
+if __name__ == '__main__':
+    main()